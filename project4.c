@@ -1,11 +1,166 @@
 #include <stdio.h>
 #include <stdlib.h>
+#include <string.h>
+#include <limits.h>
 #include <time.h>
-#define NUM_JOBS 500
+#include <math.h>
+#include <getopt.h>
+#include <pthread.h>
+#include <unistd.h>
+#include <stdatomic.h>
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <sys/wait.h>
+#if defined(__x86_64__) || defined(__i386__)
+#include <immintrin.h>
+#endif
+#define DEFAULT_NUM_JOBS 500
+#define NUM_POLICIES 10
+#define ANY_POLICY NUM_POLICIES                     // policy of the copy of the tick loop that serves every policy
+#define DEFAULT_NUM_WORKLOADS 5                     // each workload is run once under every policy, trial N runs
+                                                    // workload N / NUM_POLICIES under policy N % NUM_POLICIES
+#define POLICY_LISTS 4                              // per-process page lists a policy can keep
+#define TWOQ_IN_PERCENT 25                          // 2Q: share of a process' frames given to first-time pages
+#define TWOQ_OUT_PERCENT 50                         // 2Q: pages remembered after leaving the first-time queue
+#define LIRS_HIR_PERCENT 1                          // LIRS: share of a process' frames kept for HIR pages
+#define DEFAULT_SEED 1337
+#define TICKS_PER_SECOND 10
+#define DEFAULT_TRIAL_SECONDS 60                    // simulated length of every trial
+#define MAX_TRIAL_TICKS (1 << 29)                   // keeps every tick, and a tick plus a next-use distance, in an int
+#define THRASHING_WINDOWS 6                         // slices of the run the fault rate is reported for
+#define DEFAULT_WINDOW_TICKS 10                     // working-set window of the load controller
+#define DEFAULT_PFF_HIGH 60                         // fault percentage above which the load controller sheds load
+#define DEFAULT_PFF_LOW 40                          // fault percentage below which it lets jobs back in
+#define DEFAULT_QUEUE_DEPTH 4                       // reads the simulated disk serves at once
+#define BENCH_WARMUP_RUNS 1                         // untimed runs of a benchmark case before the timed ones
+#define BENCH_TIMED_RUNS 5                          // timed runs of a benchmark case, the median is reported
+#define BENCH_MAX_PHASE_DEPTH 8                     // phases that can be nested inside one another
+#define DEFAULT_LOG_LIMIT 100                       // references after which a traced trial stops logging
+#define LOG_BUFFER_BYTES (1 << 20)                  // per-thread event log buffer, flushed in one write when full
+#ifndef METRICS_ENABLED
+#define METRICS_ENABLED 1                           // build with -DMETRICS_ENABLED=0 to compile the metrics hooks out
+#endif
+#define METRICS_BUFFER_RECORDS 4096                 // metric records a trial thread holds before streaming them out
+#define METRICS_LATENCY_BUCKETS 8                   // fault latency histogram buckets: 0, 1, 2-3, 4-7, ... ticks
+#define METRICS_MAGIC "P4METRC"
+#define METRICS_VERSION 1
+#define STREAM_REFERENCES 0                         // per-process RNG stream that drives generateReference
+#define STREAM_VICTIMS 1                            // per-process RNG stream that drives pageReplaceRANDOM
+#define STACK_MIN_SLOTS (1 << 16)                   // smallest stamp window of the stack distance analyzer
+#define TRACE_MAGIC "P4TRACE"
+#define TRACE_VERSION 1
+#define WORKLOAD_MAGIC "P4JOBS"
+#define WORKLOAD_VERSION 1
+#define TRACE_MAX_SEGMENTS 64                       // workloads a single trace file can hold
+#define TRACE_BUFFER_RECORDS 8192                   // records buffered by the recorder between writes
+#define TRACE_EVENT_SHIFT 30                        // event kind lives in the top two bits of a record's event word
+#define TRACE_VALUE_MASK ((1u << TRACE_EVENT_SHIFT) - 1)
+#define DEFAULT_NUM_FRAMES 100
+#define FORK_WARMUP_POLICY LRU                      // policy a forked workload runs under until it forks
+#define DEFAULT_LOCALITY_PERCENT 70                 // share of references that stay on or next to the last page
+#define MAX_PROCESS_SIZES 64
+#define MIN_PROCESS_PAGES 4   // non-local references need a page at least 2 away from the last one
+#define BITMAP_WORD_BITS 64
+#define BITMAP_MAX_LEVELS 6   // 64^6 frames is far beyond anything an int frame ID can address
+#define ARENA_BLOCK_BYTES (1 << 20)                 // minimum size of an arena block
+#define ARENA_ALIGNMENT 16                          // alignment of every arena allocation
+#define ARENA_HEADER_BYTES ((sizeof(arenaBlock) + ARENA_ALIGNMENT - 1) & ~(size_t)(ARENA_ALIGNMENT - 1))
 
-int DEBUG_print_references;   // enables or disables reference notifications
-int DEBUG_print_swaps;        // enables or disables swap notifications
-int trial_statistics[25][3];  // [Trial num][jobs, hits, misses]
+long long (* trial_statistics)[3];          // [Trial num][jobs, hits, misses]
+_Thread_local struct _eventLog * activeLog; // event log of the trial running on this thread, NULL if untraced
+_Thread_local struct _phaseClock * activeClock; // phase timer of the benchmark run on this thread, NULL if untimed
+_Thread_local struct _metricsRecorder * activeMetrics; // metrics of the trial running on this thread, NULL if unrecorded
+#if METRICS_ENABLED
+#define metricsOn() (activeMetrics != NULL)
+#else
+#define metricsOn() 0
+#endif
+char * policyNames[] = {"FIFO", "LRU", "LFU", "MFU", "RANDOM", "CLOCK", "ARC", "2Q", "LIRS", "OPT"};
+
+// xoshiro256** generator; every trial, workload and process owns its own stream so results
+// do not depend on the order trials run in or on which thread runs them
+typedef struct _rng {
+    unsigned long long state[4];
+} rng;
+
+typedef enum _policy {FIFO, LRU, LFU, MFU, RANDOM, CLOCK, ARC, TWOQ, LIRS, OPT} policy;
+
+// the tick loop and the reference path under it are compiled once per policy: their functions take the
+// policy they are compiled for as a constant, are inlined into every copy, and fold away the branches and
+// the per-page fields the policy never reads. Every copy keeps the frames, their allocators and meta.owner
+// alike; only page fields no other code reads on that path, and their per-frame copies, may go stale.
+// The copy for ANY_POLICY reads the policy off the memory and keeps every page field, it serves shared
+// lanes, policy switches and every caller outside the tick loop
+#define POLICY_CORE static inline __attribute__((always_inline))
+#define RUNTIME_POLICY(compiled, ramPtr) ((compiled) == ANY_POLICY ? (ramPtr)->desiredPolicy : (compiled))
+
+// how the load controller decides that memory is overcommitted
+typedef enum _loadControl {
+    LOAD_NONE,                 // admit whenever a few frames are free, never suspend
+    LOAD_WORKING_SET,          // keep the sum of the working sets within the frames
+    LOAD_PFF                   // keep the page fault frequency between the low and high marks
+} loadControl;
+
+// parts of the tick loop the benchmark times separately, the time of a phase excludes the phases
+// nested inside it, and whatever is not in any of them is charged to PHASE_OTHER
+typedef enum _benchPhase {
+    PHASE_OTHER,               // bookkeeping of the tick loop, hits and policy updates
+    PHASE_KICK_OUT,            // kickOutCompletedJobs
+    PHASE_BRING_IN,            // bringInWaitingJobs
+    PHASE_GENERATE,            // generateReference
+    PHASE_REPLACE,             // pageReplace
+    PHASE_PAGING,              // pageIn and pageOut
+    NUM_PHASES
+} benchPhase;
+
+char * phaseNames[] = {"other", "kick", "bring", "gen", "repl", "page"};
+
+typedef struct _phaseClock {
+    long long nanoseconds[NUM_PHASES]; // time charged to every phase
+    benchPhase stack[BENCH_MAX_PHASE_DEPTH]; // phases entered and not yet left, the innermost one is charged
+    int depth;                 // index of the innermost phase in stack
+    long long since;           // time the innermost phase was last charged up to
+} phaseClock;
+
+// signs of thrashing collected over one trial
+typedef struct _thrashingStats {
+    long long faultsPerWindow[THRASHING_WINDOWS]; // page faults in each slice of the run
+    int peakFaultsPerSecond;   // most page faults in any one simulated second
+    int currentSecond;         // second faultsThisSecond is counting
+    int faultsThisSecond;      // page faults so far in currentSecond
+    int suspensions;           // processes swapped out by the load controller
+    int heldBackTicks;         // ticks in which the controller kept out an arrived job that had room
+} thrashingStats;
+
+thrashingStats * trial_thrashing;           // thrashing indicators of every trial
+
+// outcome of the prefetcher and the disk reads over one trial
+typedef struct _prefetchStats {
+    long long issued;          // pages read ahead of a reference
+    long long used;            // prefetched pages referenced while still in memory
+    long long wasted;          // prefetched pages evicted before they were referenced
+    long long savedFaults;     // references that hit only because their prefetch had completed
+    long long lateHits;        // references that found their prefetched page still being read
+    long long stallTicks;      // ticks references waited on the disk, for demand faults and late prefetches
+} prefetchStats;
+
+prefetchStats * trial_prefetch;             // prefetch statistics of every trial
+
+// what each policy keeps in the process' policy lists, ghost lists hold pages no longer in memory
+typedef enum _policyList {
+    LIST_NONE = -1,
+    LIST_RESIDENT = 0,         // FIFO/LRU: resident pages in victim order, CLOCK: the clock ring
+    ARC_T1 = 0,                // ARC: resident pages referenced once recently
+    ARC_T2 = 1,                // ARC: resident pages referenced at least twice recently
+    ARC_B1 = 2,                // ARC: ghosts evicted from T1
+    ARC_B2 = 3,                // ARC: ghosts evicted from T2
+    TWOQ_A1IN = 0,             // 2Q: resident pages seen once, FIFO
+    TWOQ_AM = 1,               // 2Q: resident hot pages, LRU
+    TWOQ_A1OUT = 2,            // 2Q: ghosts that left A1in
+    LIRS_STACK = 0,            // LIRS: recency stack S holding LIR pages and recent HIR pages, oldest first
+    LIRS_QUEUE = 1             // LIRS: resident HIR pages, linked through the queue links
+} policyList;
 
 typedef struct _page {
     int pageID;                // ID of the page, numbered 0 to (numberOfPages - 1) for each process
@@ -14,705 +169,4869 @@ typedef struct _page {
     int timeLastReferenced;    // time the page was last referenced by the process
     int referenceCount;        // the number of times the page has been referenced
     int pid;                   // ID of the process the page belongs to
-    struct _page * nextPtr;    // pointer to next page in the list
     int physPageID;            // ID of physical page in memory. corresponds to memID
+    struct _page * prevResident; // previous page in the owner's policy list named by policyList
+    struct _page * nextResident; // next page in the owner's policy list named by policyList
+    int policyList;            // list of the owner holding the page, LIST_NONE if none
+    struct _page * prevQueued; // LIRS: previous page in the owner's resident HIR queue
+    struct _page * nextQueued; // LIRS: next page in the owner's resident HIR queue
+    int queued;                // LIRS: 1 while the page is in the resident HIR queue
+    int lirsHot;               // LIRS: 1 for a LIR page, 0 for a HIR page
+    int referenceBit;          // CLOCK: set by every reference, cleared as the hand passes
+    int freshlyPagedIn;        // 1 until the reference that faulted the page in has reached the policy
+    int heapIndex;             // position in the owner's LFU/MFU/OPT heap while in memory
+    int nextUse;               // OPT: when the page is next referenced, INT_MAX if it never is again
+    int prefetched;            // 1 from being read ahead until its first reference or its eviction
+    int readyAt;               // time the read of a prefetched page completes
+    int stackSlot;             // slot of the page's latest reference in the stack distance window, -1 if none
 } page;
 
+// intrusive list of pages, oldest first
+typedef struct _pageList {
+    page * head;               // oldest page
+    page * tail;               // newest page
+    int size;                  // number of pages in the list
+} pageList;
+
+// victim structures of one replacement domain: a process under local replacement, or every frame
+// of memory under global replacement
+typedef struct _victimState {
+    int residentCount;         // number of pages of the domain in memory
+    pageList policyLists[POLICY_LISTS]; // page lists of the list-based policies, see policyList
+    page * clockHand;          // CLOCK: next page the hand inspects
+    int arcTarget;             // ARC: adaptive target size of T1
+    int arcCapacity;           // ARC: c, the most frames the domain can hold
+    int lirsCount;             // LIRS: number of LIR pages
+    page ** victimHeap;        // LFU/MFU: binary heap of resident pages with the victim on top
+    int victimHeapSize;        // number of pages in victimHeap
+    int * residentTree;        // RANDOM: Fenwick tree counting resident pages by key
+    int treeSize;              // RANDOM: number of keys, pages of the process or frames of memory
+    int keyedByFrame;          // RANDOM: 1 if keys are frames, 0 if they are pageIDs
+} victimState;
+
 typedef struct _memory {
     int busy;                  // 0 if the memory page is free
     page * pagePtr;            // pointer to page in memory
-    struct _memory * nextPtr;  // pointer to next page of memory in the list
-    int memID;                 // ID of physical page in memory
+    int memID;                 // ID of physical page in memory, equal to its index in the frame table
 } memory;
 
+// Mattson LRU stack distance analyzer. Each page's latest reference holds one slot in a window of
+// stamps and a Fenwick tree counts occupied slots, so the number of distinct pages referenced since
+// a page was last used is a prefix query. When the window fills, the live slots are compacted to
+// the front, which keeps memory proportional to the live pages rather than to the trace length.
+typedef struct _stackDistance {
+    int maxFrames;                  // largest memory size the miss ratio curve is computed for
+    int capacity;                   // number of slots in the window
+    int nextSlot;                   // next unused slot
+    int liveCount;                  // number of pages in the stack
+    int * tree;                     // Fenwick tree over slots, 1 where a slot holds a page's latest reference
+    struct _page ** slotOwner;      // page whose latest reference occupies each slot, NULL if stale
+    long long * distanceCounts;     // [d] references found at stack distance d, for d in 1..maxFrames
+    long long deepReferences;       // references deeper than maxFrames
+    long long coldReferences;       // first references to a page
+} stackDistance;
+
+// kinds of events stored in a binary reference trace
+typedef enum _traceEvent {
+    TRACE_BEGIN,               // start of a workload, pid holds the workload number
+    TRACE_ARRIVE,              // startProcess, value holds the process size in pages
+    TRACE_REFERENCE,           // reference by a running process, value holds the page ID
+    TRACE_EXIT                 // stopProcess
+} traceEvent;
+
+// one fixed size trace record, read in place from the mapped file during replay
+typedef struct _traceRecord {
+    int time;                  // tick the event happened at
+    int pid;                   // process the event belongs to, or the workload number for TRACE_BEGIN
+    unsigned int event;        // traceEvent in the top bits, page ID or process size in the rest
+} traceRecord;
+
+typedef struct _traceHeader {
+    char magic[8];                                 // TRACE_MAGIC
+    int version;                                   // TRACE_VERSION
+    int recordSize;                                // sizeof(traceRecord) of the writer
+    int numberOfFrames;                            // memory size the trace was recorded with
+    int numberOfSegments;                          // number of workloads in the trace
+    long long numberOfRecords;                     // records following the header
+    long long segmentStart[TRACE_MAX_SEGMENTS + 1]; // index of each workload's TRACE_BEGIN, then numberOfRecords
+} traceHeader;
+
+typedef struct _traceRecorder {
+    FILE * file;                                   // trace being written
+    traceHeader header;                            // rewritten at the start of the file on close
+    traceRecord buffer[TRACE_BUFFER_RECORDS];      // records not yet written
+    int bufferedRecords;                           // number of records in buffer
+} traceRecorder;
+
+// kinds of records in the binary event log
+typedef enum _logEvent {
+    LOG_TRIAL,                 // start of a traced trial, pid holds the trial number, payload the policy
+    LOG_ENTER,                 // startProcess, payload: size, service time
+    LOG_EXIT,                  // stopProcess, payload: size, service time
+    LOG_MAP,                   // memory map, payload: owning pid of every frame or -1 if free
+    LOG_HIT,                   // payload: page ID, frame
+    LOG_MISS,                  // payload: page ID, frame
+    LOG_MISS_REPLACE           // payload: page ID, frame, page ID paged out
+} logEvent;
+
+// how much a traced trial logs
+typedef enum _logVerbosity {
+    LOG_OFF,                   // nothing
+    LOG_SWAPS,                 // process entries and exits with memory maps
+    LOG_REFERENCES             // swaps and every sampled reference
+} logVerbosity;
+
+typedef struct _logRecord {
+    int event;                 // logEvent
+    int time;                  // tick of the event
+    int pid;                   // process the event belongs to, or the trial number for LOG_TRIAL
+    int payloadWords;          // number of ints following the record
+} logRecord;
+
+// per-thread event log: records are appended to a buffer and written to the sink in large batches
+typedef struct _eventLog {
+    FILE * sink;               // binary destination of flushed records
+    char * buffer;             // records not yet flushed
+    size_t used;               // bytes in buffer
+    int verbosity;             // logVerbosity
+    int sampleInterval;        // one in this many references is logged
+    int sampleCountdown;       // references to skip before the next one is logged
+    long long referenceBudget; // references left before the trial stops logging
+} eventLog;
+
+// one chunk of arena memory, objects are carved from data after the header
+typedef struct _arenaBlock {
+    struct _arenaBlock * nextBlock;    // block filled before this one
+    size_t size;                       // usable bytes after the header
+    size_t used;                       // bytes handed out so far
+} arenaBlock;
+
+// bump allocator owning every object of a workload, released all at once
+typedef struct _arena {
+    arenaBlock * head;                 // block currently being carved
+} arena;
+
+// free-frame allocator: a live free count plus a bitmap tree where a set bit at level 0 marks a
+// free frame and a set bit at level k marks a word of level k-1 that still has a free frame
+typedef struct _frameAllocator {
+    int freeFrameCount;                                 // number of frames currently free
+    int numberOfLevels;                                 // height of the bitmap tree, top level is one word
+    unsigned long long * levels[BITMAP_MAX_LEVELS];     // free bitmaps, level 0 has one bit per frame
+    int wordsPerLevel[BITMAP_MAX_LEVELS];               // number of words in each level
+} frameAllocator;
+
+// a slice of the frame table with its own free frames. A process is given a slice when it is admitted
+// and only ever faults into it, so under local replacement the slices can run on separate threads
+typedef struct _frameShard {
+    frameAllocator allocator;  // free frames of the slice, bit i standing for frame firstFrame + i
+    int firstFrame;            // memID of the slice's first frame
+    long long hits;            // references of the slice's processes found in memory
+    long long misses;          // references of the slice's processes that faulted
+    int tickFaults;            // faults of the current tick, folded into the thrashing indicators after it
+    struct _process ** work;   // processes referencing in the current tick, in pid order
+    int workCount;             // number of processes in work
+    int workCapacity;          // allocated length of work
+    struct _ram * ownerPtr;    // memory the slice belongs to
+    char padding[64];          // keeps the counters of neighbouring slices off each other's cache lines
+} frameShard;
+
+// threads that run the references of shards 1 and up while the trial's own thread runs shard 0
+typedef struct _shardPool {
+    pthread_t * threads;       // one per shard after the first
+    pthread_barrier_t start;   // passed once the work lists of the tick are filled, or to stop
+    pthread_barrier_t finish;  // passed once every shard has run its work list
+    int time;                  // tick being run
+    int stopping;              // set before the last start to make the threads exit
+    void (* runShardWork)(struct _frameShard *, struct _ram *, int); // copy of the tick loop the threads run
+} shardPool;
+
+// hot page metadata mirrored into dense per-frame arrays, so a scan over memory streams one array
+// instead of following every frame's pagePtr. The keys are only kept while the memory scans for victims,
+// and each one is written wherever its page field is, so it always equals that field
+typedef struct _frameMetadata {
+    int * owner;               // pid of the resident page, -1 while the frame is free
+    int * lastReferenced;      // timeLastReferenced of the resident page
+    int * pagedIn;             // timePagedIn of the resident page
+    int * referenceCount;      // referenceCount of the resident page
+} frameMetadata;
+
+typedef struct _ram {
+    int numberOfFrames;        // number of physical pages in memory
+    memory * frames;           // contiguous frame table indexed by memID
+    frameMetadata meta;        // structure-of-arrays view of the resident pages indexed by memID
+    int globalScope;           // 1 if a fault may evict any page in memory, 0 if only the faulting process' own
+    victimState globalVictims; // victim structures over every frame under global replacement
+    arena * arenaPtr;          // arena the memory and its processes live in
+    loadControl loadControl;   // load controller of this memory
+    int windowTicks;           // length of the working-set window in references of each process
+    int pffHigh;               // PFF: percentage of faulting references that sheds load
+    int pffLow;                // PFF: percentage of faulting references that lets load back in
+    int workingSetTotal;       // sum of the working sets of the running processes
+    int windowReferences;      // references inside the windows of the running processes
+    int windowFaults;          // faults among those references
+    thrashingStats thrashing;  // thrashing indicators of the trial
+    int prefetchDepth;         // pages read ahead of a sequential process, 0 to prefetch nothing
+    int diskLatency;           // ticks a disk read takes
+    int queueDepth;            // reads the disk serves at once
+    int * diskBusyUntil;       // time each of the disk's queueDepth slots finishes its read
+    prefetchStats prefetch;    // prefetch statistics of the trial
+    int trialTicks;            // length of the run, for slicing the fault rate
+    long long jobsRun;         // jobs started in this memory
+    long long hits;            // references found in memory
+    long long misses;          // references that faulted
+    struct _process * spareProcesses[MAX_PROCESS_SIZES]; // finished processes kept for reuse, by size index
+    frameAllocator allocator;  // tracks which frames are free
+    frameShard * shards;       // slices of the frame table run on separate threads, NULL if memory is one pool
+    int numberOfShards;        // number of entries in shards
+    shardPool * poolPtr;       // threads running the shards during runTicks, NULL with fewer than two shards
+    policy desiredPolicy;      // replacement policy whose victim structures are being maintained
+    int genericCore;           // 1 to run the copy of the tick loop compiled for any policy
+    int victimScan;            // 1 to find FIFO, LRU, LFU and MFU victims by scanning meta, not victim structures
+    struct _ram * nextLane;    // memory of the next policy fed the same references, NULL outside shared mode
+    stackDistance * stackPtr;  // analyzer fed every reference, NULL unless computing a miss ratio curve
+    traceRecorder * recorderPtr; // receives every scheduling event and reference, NULL unless recording
+} ram;
+
 typedef struct _process {
     int pid;                   // process ID
-    float arrivalTime;         // time the process arrived at the queue is between 0.1s and 59.9s
+    double arrivalTime;        // time the process arrived at the queue, anywhere in the run
     int serviceTime;           // time required to service the process
     int firstRunTime;          // time when the process starts
     int hitCount;              // number of page hits on this process' references
     int missCount;             // number of page misses on this process' references
-    int numberOfPages;         // size of the process represented in pages randomly chosen as either 5, 11, 17, or 31
-    page * pagePtr;            // pointer to head of its page list
+    int numberOfPages;         // size of the process represented in pages, randomly chosen from the configured sizes
+    page * pageTable;          // the process's pages indexed by pageID
     page * pageLastReferenced; // pointer to the page that the process has last referenced
     struct _process * nextPtr; // pointer to the next process in the list
+    struct _process * nextLane; // copy of this process in the next policy's lane, NULL outside shared mode
+    unsigned long long seed;   // seed of the process' own RNG streams
+    rng referenceStream;       // draws for generateReference
+    rng victimStream;          // draws for pageReplaceRANDOM
+    victimState victims;       // victim structures of the process under local replacement
+    int suspendedAt;           // time the load controller swapped the process out, -1 while not suspended
+    int suspendedTicks;        // time spent suspended, which pushes back the completion
+    int completionSlot;        // position in the scheduler's completion heap, -1 if not in it
+    int * window;              // last windowTicks references of the process as pageID * 2 + faulted, -1 if empty
+    int * windowUses;          // references of each page inside the window
+    int workingSetSize;        // distinct pages referenced inside the window
+    int windowFaults;          // faults among the references inside the window
+    int * nextUseDelta;        // OPT: references from each reference of the process to its next one of the same page
+    int numberOfReferences;    // OPT: length of nextUseDelta
+    int nextUseCapacity;       // OPT: allocated length of nextUseDelta, kept when the process is reused
+    int sizeIndex;             // index of the process' size in the configuration, -1 if not reusable
+    int localityPercent;       // share of the process' references that stay on or next to its last page
+    int referencesMade;        // references made so far, the index into nextUseDelta
+    int lastStep;              // page step between the process' last two references, for the prefetcher
+    int blockedUntil;          // time the process' outstanding disk read completes, it references nothing before
+    frameShard * shardPtr;     // slice of memory the process faults into, NULL unless memory is sliced
+#if METRICS_ENABLED
+    int faultLatency[METRICS_LATENCY_BUCKETS]; // faults by ticks blocked on the disk, bucket 0 is left to missCount
+#endif
 } process;
 
-typedef enum _policy {FIFO, LRU, LFU, MFU, RANDOM} policy;
+// event-driven view of the processes: only admitted, unfinished jobs are visited each tick
+typedef struct _scheduler {
+    struct _jobSource * sourcePtr; // jobs not yet admitted, drawn in arrival order
+    process ** completionHeap; // min-heap of running processes by completion time, ties by pid
+    int completionHeapSize;    // number of processes in completionHeap
+    process ** runQueue;       // started, unfinished processes in pid order
+    int runQueueSize;          // number of processes in runQueue
+    process ** suspended;      // processes swapped out by the load controller in pid order
+    int suspendedCount;        // number of processes in suspended
+    int capacity;              // allocated length of completionHeap, runQueue and suspended
+} scheduler;
+
+typedef enum _resultsFormat {
+    RESULTS_TEXT,              // human readable summary
+    RESULTS_CSV,               // a header, then one comma separated row per point
+    RESULTS_JSON               // one JSON object per point and line
+} resultsFormat;
+
+typedef struct _config {
+    int numberOfFrames;                      // number of physical pages in memory
+    int numberOfThreads;                     // number of trials run concurrently
+    unsigned long long seed;                 // master seed every RNG stream is derived from
+    int sharedReferences;                    // 1 to run every policy side by side on one reference stream
+    int mrcFrames;                           // largest memory size of the global LRU miss ratio curve, 0 to simulate normally
+    char * recordPath;                       // trace file to record the workloads into, NULL if not recording
+    char * replayPath;                       // trace file to replay under every policy, NULL if not replaying
+    int logVerbosity;                        // logVerbosity of the traced trials
+    long long logLimit;                      // references after which a traced trial stops logging
+    int logSampleInterval;                   // one in this many references is logged
+    char * logPath;                          // binary file for the event log, NULL to print it formatted
+    char * formatLogPath;                    // event log file to print formatted instead of simulating
+    int benchLayout;                         // 1 to benchmark victim scans over both page metadata layouts
+    int benchSuite;                          // 1 to time the simulator on every policy at several scales
+    char * scanKernel;                       // frame scan kernel to force, NULL to pick the best the CPU supports
+    int globalScope;                         // 1 to let a fault evict a page of any process
+    loadControl loadControl;                 // load controller deciding admission and suspension
+    int windowTicks;                         // working-set window of the load controller in references
+    int pffHigh;                             // fault percentage above which the PFF controller suspends
+    int pffLow;                              // fault percentage below which the PFF controller admits
+    int reportThrashing;                     // 1 to print the thrashing indicators of every trial
+    int prefetchDepth;                       // pages read ahead of a sequential process, 0 for demand paging only
+    int diskLatency;                         // ticks a disk read takes
+    int queueDepth;                          // reads the disk serves at once
+    int numberOfProcessSizes;                // number of entries in processSizes
+    int processSizes[MAX_PROCESS_SIZES];     // process sizes in pages, each chosen with equal probability
+    int numberOfJobs;                        // jobs arriving in every workload
+    int numberOfWorkloads;                   // workloads every policy is run on
+    int trialSeconds;                        // simulated length of every trial
+    int localityPercent;                     // share of references that stay on or next to the last page
+    char * sweepPath;                        // grid spec of a parameter sweep, NULL to run a single configuration
+    char * resultsPath;                      // file the results are written to, NULL for standard output
+    resultsFormat resultsFormat;             // how the results are written
+    int forkSeconds;                         // second every workload forks into one child per policy at, -1 to not fork
+    int numberOfShards;                      // frame pools a trial's memory is split into, each run on its own thread,
+                                             // 0 to keep memory one pool
+    char * saveWorkloadsPath;                // file to write the generated workloads to, NULL to simulate
+    char * workloadsPath;                    // workload file to run instead of generating workloads, NULL to generate
+    struct _mappedWorkloads * workloadsPtr;  // mapping of workloadsPath, NULL when generating
+    char * metricsPath;                      // file the per-tick and per-process metrics stream to, NULL to not record
+    int metricsBinary;                       // 1 to write the metrics as binary records, 0 as csv rows
+    struct _metricsSink * metricsSinkPtr;    // open metricsPath, NULL when not recording
+    int genericCore;                         // 1 to run every trial in the tick loop compiled for any policy
+    int victimScan;                          // 1 to find victims by scanning the per-frame metadata
+} config;
 
-// create the linked list of memory pages and return pointer to head node
-memory * downloadRAM() {
-     memory * rootPtr;
-     memory * nodePtr;
+// a job of a workload, drawn when it becomes the next to arrive
+typedef struct _job {
+    int pid;                   // ID the job runs under, numbered in arrival order
+    double arrivalTime;        // tick the job arrives at
+    int serviceTime;           // ticks the job runs for
+    int sizeIndex;             // index of the job's size in the configured process sizes
+    unsigned long long seed;   // seed of the job's own RNG streams
+} job;
 
-     rootPtr = malloc(sizeof(memory));
-     rootPtr->busy = 0;
-     rootPtr->pagePtr = NULL;
-     rootPtr->nextPtr = NULL;
-     rootPtr->memID = 0;
-     nodePtr = rootPtr;
+// streams a workload's jobs in arrival order, holding only the next one
+typedef struct _jobSource {
+    config * cfg;              // configuration the jobs are drawn from
+    rng stream;                // draws of the workload
+    int jobsLeft;              // jobs still to arrive, including next
+    int trialTicks;            // length of the run the arrivals are spread over
+    double arrivalFraction;    // position of the latest arrival within the run, between 0 and 1
+    job * jobs;                // the workload's jobs read in place from a workload file, NULL when drawn
+    job next;                  // next job to arrive, valid while jobsLeft > 0
+} jobSource;
 
+// a workload file is this header followed by the jobs of every workload in arrival order, workload
+// after workload, stored as the job structs themselves so the mapped file is used without parsing
+typedef struct _workloadHeader {
+    char magic[8];                           // WORKLOAD_MAGIC
+    int version;                             // WORKLOAD_VERSION
+    int jobSize;                             // sizeof(job) of the writer
+    int numberOfWorkloads;                   // workloads in the file
+    int numberOfJobs;                        // jobs of every workload
+    int trialSeconds;                        // length of the run the arrivals are spread over
+    int numberOfProcessSizes;                // number of entries in processSizes
+    int processSizes[MAX_PROCESS_SIZES];     // sizes the jobs' sizeIndex refers to
+} workloadHeader;
+
+typedef struct _mappedWorkloads {
+    workloadHeader * header;   // start of the mapping
+    job * jobs;                // jobs directly following the header
+    size_t length;             // length of the mapping in bytes
+} mappedWorkloads;
+
+typedef enum _metricKind {
+    METRIC_TICK,               // state of memory and the scheduler at the end of a tick
+    METRIC_PROCESS             // outcome of a process, written when it finishes
+} metricKind;
+
+typedef struct _tickMetrics {
+    int faults;                // page faults in the tick
+    int freeFrames;            // free frames at the end of the tick
+    int activeJobs;            // processes in the run queue
+    int queuedJobs;            // arrived jobs bringInWaitingJobs has not admitted yet
+} tickMetrics;
+
+typedef struct _processMetrics {
+    int size;                  // pages of the process
+    int waitTicks;             // ticks between the first one the process could have started in and its start
+    long long hits;            // references found in memory
+    long long misses;          // references that faulted
+    int faultLatency[METRICS_LATENCY_BUCKETS]; // faults by ticks blocked on the disk
+} processMetrics;
+
+// one fixed size metric record, written as is to a binary metrics file after a metricsHeader
+typedef struct _metricRecord {
+    int kind;                  // metricKind
+    int trial;                 // trial the record belongs to
+    int time;                  // tick sampled, or tick the process finished in
+    int pid;                   // process of a METRIC_PROCESS record, -1 for a tick
+    union {
+        tickMetrics tick;
+        processMetrics process;
+    };
+} metricRecord;
+
+typedef struct _metricsHeader {
+    char magic[8];             // METRICS_MAGIC
+    int version;               // METRICS_VERSION
+    int recordSize;            // sizeof(metricRecord) of the writer
+} metricsHeader;
+
+// the metrics file every trial thread streams its records into
+typedef struct _metricsSink {
+    FILE * file;               // metricsPath
+    int binary;                // 1 for metricRecords, 0 for csv rows
+    int failed;                // set once a write fails
+    pthread_mutex_t lock;      // held while a thread writes out its records
+} metricsSink;
+
+// the records of the trial running on a thread, preallocated once per thread and streamed out whenever full
+typedef struct _metricsRecorder {
+    metricsSink * sinkPtr;     // file the records go to
+    int trial;                 // trial being recorded
+    long long faultsCounted;   // faults of the trial up to the last tick sample
+    int queuedJobs;            // queue length seen by the last bringInWaitingJobs
+    int arrivalsStarted;       // 1 once arrivals has been copied from the trial's job source
+    jobSource arrivals;        // runs ahead of the scheduler's job source to the jobs that have arrived
+    metricRecord buffer[METRICS_BUFFER_RECORDS]; // records not yet written
+    int bufferedRecords;       // number of records in buffer
+} metricsRecorder;
+
+unsigned long long splitMix64(unsigned long long * x) {
+     unsigned long long z = (*x += 0x9E3779B97F4A7C15ULL);
+     z = (z ^ (z >> 30)) * 0xBF58476D1CE4E5B9ULL;
+     z = (z ^ (z >> 27)) * 0x94D049BB133111EBULL;
+     return z ^ (z >> 31);
+}
+
+// seeds the generator with an independent stream identified by (seed, streamID)
+void rngSeed(rng * rngPtr, unsigned long long seed, unsigned long long streamID) {
+     unsigned long long x = seed;
+     unsigned long long mixedStream = streamID;
+     x ^= splitMix64(&mixedStream);
      int i;
-     for (i = 1; i < 100; ++i) {
-          nodePtr->nextPtr = malloc(sizeof(memory));
-          nodePtr = nodePtr->nextPtr;
-          nodePtr->busy = 0;
-          nodePtr->pagePtr = NULL;
-          nodePtr->nextPtr = NULL;
-          nodePtr->memID = i;
-     }
+     for (i = 0; i < 4; ++i)
+          rngPtr->state[i] = splitMix64(&x);
+}
 
-     return rootPtr;
+unsigned long long rotateLeft(unsigned long long x, int k) {
+     return (x << k) | (x >> (64 - k));
 }
 
-// randomly select the process size in pages
-int randomNumberOfPages() {
-     int r = rand() % 4;
-     int numberOfPages;
+unsigned long long rngNext(rng * rngPtr) {
+     unsigned long long * s = rngPtr->state;
+     unsigned long long result = rotateLeft(s[1] * 5, 7) * 9;
+     unsigned long long t = s[1] << 17;
+     s[2] ^= s[0];
+     s[3] ^= s[1];
+     s[1] ^= s[2];
+     s[0] ^= s[3];
+     s[2] ^= t;
+     s[3] = rotateLeft(s[3], 45);
+     return result;
+}
 
-     switch (r) {
-          case 0:
-               numberOfPages = 5;
-               break;
-          case 1:
-               numberOfPages = 11;
-               break;
-          case 2:
-               numberOfPages = 17;
-               break;
-          case 3:
-               numberOfPages = 31;
-               break;
-          default:
-               printf("HOW\n");
-               exit(1);
+// returns a uniformly distributed integer in [0, bound)
+int rngBelow(rng * rngPtr, int bound) {
+     unsigned long long product = (rngNext(rngPtr) >> 32) * (unsigned long long)bound;
+     unsigned int low = (unsigned int)product;
+     if (low < (unsigned int)bound) {
+          // reject the few values that would make small results more likely
+          unsigned int threshold = (unsigned int)(-bound) % (unsigned int)bound;
+          while (low < threshold) {
+               product = (rngNext(rngPtr) >> 32) * (unsigned long long)bound;
+               low = (unsigned int)product;
+          }
      }
+     return (int)(product >> 32);
+}
 
-     return numberOfPages;
+// returns a uniformly distributed double in [0, 1)
+double rngUniform(rng * rngPtr) {
+     return (double)(rngNext(rngPtr) >> 11) * (1.0 / 9007199254740992.0);
 }
 
-// Creates the linked list for the process's pages and returns a pointer to head of the list
-page * generateProcessPageList(process * pageListOwner) {
-     page * rootPtr;
-     page * nodePtr;
+long long monotonicNanoseconds() {
+     struct timespec now;
+     clock_gettime(CLOCK_MONOTONIC, &now);
+     return now.tv_sec * 1000000000LL + now.tv_nsec;
+}
 
-     rootPtr = malloc(sizeof(page));
-     rootPtr->pageID = 0;
-     rootPtr->inMemory = 0;
-     rootPtr->timePagedIn = -1;
-     rootPtr->timeLastReferenced = -1;
-     rootPtr->referenceCount = 0;
-     rootPtr->pid = pageListOwner->pid;
-     rootPtr->nextPtr = NULL;
-     nodePtr = rootPtr;
+// charges the time since the last switch to the innermost phase of the thread's benchmark
+void chargePhase(phaseClock * clockPtr) {
+     long long now = monotonicNanoseconds();
+     clockPtr->nanoseconds[clockPtr->stack[clockPtr->depth]] += now - clockPtr->since;
+     clockPtr->since = now;
+}
 
-     int i;
-     for (i = 1; i < pageListOwner->numberOfPages; ++i) {
-          nodePtr->nextPtr = malloc(sizeof(page));
-          nodePtr = nodePtr->nextPtr;
-          nodePtr->pageID = i;
-          nodePtr->inMemory = 0;
-          nodePtr->timePagedIn = -1;
-          nodePtr->timeLastReferenced = -1;
-          nodePtr->referenceCount = 0;
-          nodePtr->pid = pageListOwner->pid;
-          nodePtr->nextPtr = NULL;
-     }
+// starts timing a phase, does nothing unless a benchmark is timing this thread
+void enterPhase(benchPhase phase) {
+     if (!activeClock)
+          return;
+     chargePhase(activeClock);
+     activeClock->stack[++activeClock->depth] = phase;
+}
 
-     return rootPtr;
+// goes back to timing the phase that was running before the innermost one
+void leavePhase() {
+     if (!activeClock)
+          return;
+     chargePhase(activeClock);
+     --activeClock->depth;
 }
 
-void resetMetadata(memory * memPtr, process * procPtr) {
-     while(memPtr) {
-          memPtr->busy = 0;
-          memPtr->pagePtr = NULL;
-          memPtr = memPtr->nextPtr;
-     }
-     
-     while(procPtr) {
-          page * pagePtr = procPtr->pagePtr;
-          while(pagePtr) {
-               pagePtr->inMemory = 0;
-               pagePtr->timePagedIn = -1;
-               pagePtr->timeLastReferenced = -1;
-               pagePtr->referenceCount = 0;
-               pagePtr->physPageID = -1; 
-               pagePtr = pagePtr->nextPtr;
-          }
-          procPtr->firstRunTime = -1;
-          procPtr->hitCount = 0;
-          procPtr->missCount = 0;
-          procPtr->pageLastReferenced = NULL; 
-          procPtr = procPtr->nextPtr;
+arenaBlock * newArenaBlock(size_t size, arenaBlock * nextBlock) {
+     arenaBlock * blockPtr = malloc(ARENA_HEADER_BYTES + size);
+     if (!blockPtr) {
+          printf("ERROR OUT OF MEMORY\n");
+          exit(1);
      }
+     blockPtr->nextBlock = nextBlock;
+     blockPtr->size = size;
+     blockPtr->used = 0;
+     return blockPtr;
 }
 
-void freeProcesses(process * procPtr) {
-     process * tempProc;
-     page * tempPage;
-     while (procPtr) {
-          page * pagePtr = procPtr->pagePtr;
-          while (pagePtr) {
-               tempPage = pagePtr;
-               pagePtr = pagePtr->nextPtr;
-               free(tempPage);
-          }
-          tempProc = procPtr;
-          procPtr = procPtr->nextPtr;
-          free(tempProc);
-     }
+void initArena(arena * arenaPtr) {
+     arenaPtr->head = newArenaBlock(ARENA_BLOCK_BYTES, NULL);
+}
 
+// returns uninitialized memory that lives until the arena is reset
+void * arenaAlloc(arena * arenaPtr, size_t size) {
+     size = (size + ARENA_ALIGNMENT - 1) & ~(size_t)(ARENA_ALIGNMENT - 1);
+     arenaBlock * blockPtr = arenaPtr->head;
+     if (blockPtr->used + size > blockPtr->size) {
+          blockPtr = newArenaBlock(size > ARENA_BLOCK_BYTES ? size : ARENA_BLOCK_BYTES, blockPtr);
+          arenaPtr->head = blockPtr;
+     }
+     void * ptr = (char *)blockPtr + ARENA_HEADER_BYTES + blockPtr->used;
+     blockPtr->used += size;
+     return ptr;
 }
 
-void freeMemory(memory * memPtr) {
-     memory * tempMem;
-     while(memPtr) {
-          tempMem = memPtr;
-          memPtr = memPtr->nextPtr;
-          free(tempMem);
+// releases everything allocated from the arena
+// if the last workload overflowed into several blocks they are merged into one big enough for it
+void resetArena(arena * arenaPtr) {
+     arenaBlock * blockPtr = arenaPtr->head;
+     if (!blockPtr->nextBlock) {
+          blockPtr->used = 0;
+          return;
+     }
+     size_t total = 0;
+     while (blockPtr) {
+          arenaBlock * nextBlock = blockPtr->nextBlock;
+          total += blockPtr->size;
+          free(blockPtr);
+          blockPtr = nextBlock;
      }
+     arenaPtr->head = newArenaBlock(total, NULL);
 }
 
-// function that compares two values for qsort()
-int compareArrivalTimes(const void * a, const void * b) {
-     if (*(float *) a < *(float *) b)
-          return -1;
-     else if ( *(float *) a > *(float *) b)
-          return 1;
-     else
-          return 0;
+void freeArena(arena * arenaPtr) {
+     arenaBlock * blockPtr = arenaPtr->head;
+     while (blockPtr) {
+          arenaBlock * nextBlock = blockPtr->nextBlock;
+          free(blockPtr);
+          blockPtr = nextBlock;
+     }
+     arenaPtr->head = NULL;
 }
 
-// generates and sorts the arrival times for the processes into an array
-float * generateArrivalTimes() {
-     float * arrivalTimes = malloc(sizeof(float) * NUM_JOBS);
+// marks every frame free
+void resetFrameAllocator(frameAllocator * allocPtr, int numberOfFrames) {
+     int level;
+     int bits = numberOfFrames;
+     for (level = 0; level < allocPtr->numberOfLevels; ++level) {
+          int i;
+          for (i = 0; i < allocPtr->wordsPerLevel[level]; ++i) {
+               int remaining = bits - i * BITMAP_WORD_BITS;
+               if (remaining >= BITMAP_WORD_BITS)
+                    allocPtr->levels[level][i] = ~0ULL;
+               else
+                    allocPtr->levels[level][i] = (1ULL << remaining) - 1;
+          }
+          bits = allocPtr->wordsPerLevel[level];
+     }
+     allocPtr->freeFrameCount = numberOfFrames;
+}
 
-     int i;
-     for (i = 0; i < NUM_JOBS; ++i)
-          arrivalTimes[i] = ((((float)rand() / (float)(RAND_MAX))) * 600) ;
+void initFrameAllocator(frameAllocator * allocPtr, int numberOfFrames, arena * arenaPtr) {
+     int words = numberOfFrames;
+     allocPtr->numberOfLevels = 0;
+     do {
+          words = (words + BITMAP_WORD_BITS - 1) / BITMAP_WORD_BITS;
+          allocPtr->wordsPerLevel[allocPtr->numberOfLevels] = words;
+          allocPtr->levels[allocPtr->numberOfLevels] = arenaAlloc(arenaPtr, sizeof(unsigned long long) * words);
+          ++allocPtr->numberOfLevels;
+     } while (words > 1);
+     resetFrameAllocator(allocPtr, numberOfFrames);
+}
 
-     qsort(arrivalTimes, NUM_JOBS, sizeof(float), compareArrivalTimes);
+// returns the lowest numbered free frame without taking it, or -1 if memory is full
+int lowestFreeFrame(frameAllocator * allocPtr) {
+     if (allocPtr->freeFrameCount == 0)
+          return -1;
 
-     return arrivalTimes;
+     int index = 0;
+     int level;
+     for (level = allocPtr->numberOfLevels - 1; level >= 0; --level)
+          index = index * BITMAP_WORD_BITS + __builtin_ctzll(allocPtr->levels[level][index]);
+     return index;
 }
 
-// generate ordered linked list of processes and return pointer to head node
-process * generateProcesses() {
-     process * rootPtr;
-     process * nodePtr;
+// marks a free frame as taken
+void takeFrame(frameAllocator * allocPtr, int memID) {
+     int index = memID;
+     int level;
+     for (level = 0; level < allocPtr->numberOfLevels; ++level) {
+          unsigned long long * word = &allocPtr->levels[level][index / BITMAP_WORD_BITS];
+          *word &= ~(1ULL << (index % BITMAP_WORD_BITS));
+          if (*word)
+               break;   // word still has a free frame so the levels above are unchanged
+          index /= BITMAP_WORD_BITS;
+     }
+     --allocPtr->freeFrameCount;
+}
 
-     float * sortedArrivalTimes = generateArrivalTimes();
+// marks a taken frame as free
+void releaseFrame(frameAllocator * allocPtr, int memID) {
+     int index = memID;
+     int level;
+     for (level = 0; level < allocPtr->numberOfLevels; ++level) {
+          unsigned long long * word = &allocPtr->levels[level][index / BITMAP_WORD_BITS];
+          int wasEmpty = (*word == 0);
+          *word |= 1ULL << (index % BITMAP_WORD_BITS);
+          if (!wasEmpty)
+               break;   // the levels above already know this word has a free frame
+          index /= BITMAP_WORD_BITS;
+     }
+     ++allocPtr->freeFrameCount;
+}
 
-     rootPtr = malloc(sizeof(process));
-     rootPtr->pid = 0;
-     rootPtr->arrivalTime = sortedArrivalTimes[0];
-     rootPtr->serviceTime = ((rand() % 5) + 1) * 10;
-     rootPtr->firstRunTime = -1;
-     rootPtr->hitCount = 0;
-     rootPtr->missCount = 0;
-     rootPtr->numberOfPages = randomNumberOfPages();
-     rootPtr->pagePtr = generateProcessPageList(rootPtr);
-     rootPtr->pageLastReferenced = NULL;
-     rootPtr->nextPtr = NULL;
-     nodePtr = rootPtr;
+// allocate the frame table for the requested number of physical pages and return pointer to it
+ram * downloadRAM(int numberOfFrames, arena * arenaPtr) {
+     ram * ramPtr = arenaAlloc(arenaPtr, sizeof(ram));
+     ramPtr->numberOfFrames = numberOfFrames;
+     ramPtr->frames = arenaAlloc(arenaPtr, sizeof(memory) * numberOfFrames);
+     ramPtr->meta.owner = arenaAlloc(arenaPtr, sizeof(int) * numberOfFrames);
+     ramPtr->meta.lastReferenced = arenaAlloc(arenaPtr, sizeof(int) * numberOfFrames);
+     ramPtr->meta.pagedIn = arenaAlloc(arenaPtr, sizeof(int) * numberOfFrames);
+     ramPtr->meta.referenceCount = arenaAlloc(arenaPtr, sizeof(int) * numberOfFrames);
+     ramPtr->nextLane = NULL;
+     ramPtr->stackPtr = NULL;
+     ramPtr->recorderPtr = NULL;
+     ramPtr->globalScope = 0;
+     ramPtr->arenaPtr = arenaPtr;
+     ramPtr->loadControl = LOAD_NONE;
+     ramPtr->windowTicks = 0;
+     ramPtr->workingSetTotal = 0;
+     ramPtr->windowReferences = 0;
+     ramPtr->windowFaults = 0;
+     memset(&ramPtr->thrashing, 0, sizeof(thrashingStats));
+     ramPtr->prefetchDepth = 0;
+     ramPtr->diskLatency = 0;
+     ramPtr->queueDepth = 1;
+     ramPtr->diskBusyUntil = arenaAlloc(arenaPtr, sizeof(int));
+     ramPtr->diskBusyUntil[0] = 0;
+     memset(&ramPtr->prefetch, 0, sizeof(prefetchStats));
+     ramPtr->trialTicks = DEFAULT_TRIAL_SECONDS * TICKS_PER_SECOND;
+     ramPtr->jobsRun = 0;
+     ramPtr->hits = 0;
+     ramPtr->misses = 0;
+     memset(ramPtr->spareProcesses, 0, sizeof(ramPtr->spareProcesses));
 
      int i;
-     for (i = 1; i < NUM_JOBS; ++i) {
-          nodePtr->nextPtr = malloc(sizeof(process));
-          nodePtr = nodePtr->nextPtr;
-          nodePtr->pid = i;
-          nodePtr->arrivalTime = sortedArrivalTimes[i];
-          nodePtr->serviceTime = ((rand() % 5) + 1) * 10;
-          nodePtr->firstRunTime = -1;
-          nodePtr->hitCount = 0;
-          nodePtr->missCount = 0;
-          nodePtr->numberOfPages = randomNumberOfPages();
-          nodePtr->pagePtr = generateProcessPageList(nodePtr);
-          nodePtr->pageLastReferenced = NULL;
-          nodePtr->nextPtr = NULL;
+     for (i = 0; i < numberOfFrames; ++i) {
+          ramPtr->frames[i].busy = 0;
+          ramPtr->frames[i].pagePtr = NULL;
+          ramPtr->frames[i].memID = i;
+          ramPtr->meta.owner[i] = -1;
+          ramPtr->meta.lastReferenced[i] = 0;
+          ramPtr->meta.pagedIn[i] = 0;
+          ramPtr->meta.referenceCount[i] = 0;
      }
+     initFrameAllocator(&ramPtr->allocator, numberOfFrames, arenaPtr);
+     ramPtr->shards = NULL;
+     ramPtr->numberOfShards = 0;
+     ramPtr->poolPtr = NULL;
+     ramPtr->genericCore = 0;
+     ramPtr->victimScan = 0;
 
-     return rootPtr;
+     return ramPtr;
 }
 
-// returns total number of free pages in memory
-int numberOfFreePages (memory * memPtr) {
-     int freePages = 0;
+// randomly select the index of the process size
+int randomProcessSize(config * cfg, rng * rngPtr) {
+     return rngBelow(rngPtr, cfg->numberOfProcessSizes);
+}
 
-     while (memPtr) {
-          if (memPtr->busy == 0)
-               ++freePages;
-          memPtr = memPtr->nextPtr;
+// sets every page of the process' page table to not yet referenced
+void initPageTable(process * pageTableOwner) {
+     page * pageTable = pageTableOwner->pageTable;
+     int i;
+     for (i = 0; i < pageTableOwner->numberOfPages; ++i) {
+          pageTable[i].pageID = i;
+          pageTable[i].inMemory = 0;
+          pageTable[i].timePagedIn = -1;
+          pageTable[i].timeLastReferenced = -1;
+          pageTable[i].referenceCount = 0;
+          pageTable[i].pid = pageTableOwner->pid;
+          pageTable[i].physPageID = -1;
+          pageTable[i].prevResident = NULL;
+          pageTable[i].nextResident = NULL;
+          pageTable[i].policyList = LIST_NONE;
+          pageTable[i].prevQueued = NULL;
+          pageTable[i].nextQueued = NULL;
+          pageTable[i].queued = 0;
+          pageTable[i].lirsHot = 0;
+          pageTable[i].referenceBit = 0;
+          pageTable[i].freshlyPagedIn = 0;
+          pageTable[i].heapIndex = -1;
+          pageTable[i].nextUse = INT_MAX;
+          pageTable[i].prefetched = 0;
+          pageTable[i].readyAt = 0;
+          pageTable[i].stackSlot = -1;
      }
-     
-     return freePages;
 }
 
-// returns the number of pages in memory that belong to the specified process
-int numberOfProcessPagesInMemory(int pid, memory * memPtr) {
-     int count = 0;
-     while (memPtr) {
-          if ((memPtr->busy) && (memPtr->pagePtr->pid == pid)) {
-               ++count;
-          }
-          memPtr = memPtr->nextPtr;
-     }
-     return count;
+// forgets every resident page of the domain
+void clearVictimState(victimState * statePtr) {
+     statePtr->residentCount = 0;
+     memset(statePtr->policyLists, 0, sizeof(statePtr->policyLists));
+     statePtr->clockHand = NULL;
+     statePtr->arcTarget = 0;
+     statePtr->lirsCount = 0;
+     statePtr->victimHeapSize = 0;
+     memset(statePtr->residentTree, 0, sizeof(int) * (statePtr->treeSize + 1));
 }
 
-// returns memory address of first free page in memory
-memory * firstFreePage(memory * memPtr) {
-     while (memPtr) {
-          if (memPtr->busy == 0)
-               return memPtr;
-          memPtr = memPtr->nextPtr;
-     }
-     return memPtr;
+// allocates the structures used to pick replacement victims among up to capacity pages
+void initVictimState(victimState * statePtr, int capacity, int keyedByFrame, arena * arenaPtr) {
+     statePtr->victimHeap = arenaAlloc(arenaPtr, sizeof(page *) * capacity);
+     statePtr->residentTree = arenaAlloc(arenaPtr, sizeof(int) * (capacity + 1));
+     statePtr->treeSize = capacity;
+     statePtr->keyedByFrame = keyedByFrame;
+     statePtr->arcCapacity = capacity;
+     clearVictimState(statePtr);
 }
 
-memory * findPageInMemory(page * pagePtr, memory * memPtr) {
-     while (memPtr) {
-          if (memPtr->pagePtr && memPtr->pagePtr == pagePtr) {
-               return memPtr;
+// draws the job arriving after the current one
+// the jobs arrive at uniformly random times, and of r arrivals still to come over what is left of the
+// run the first one lies a fraction 1 - U^(1/r) of the way in, so the sorted times stream out one at a time
+// a mapped workload hands out its stored jobs instead, checking each only as far as the simulator relies on it
+void drawNextJob(jobSource * sourcePtr) {
+     if (--sourcePtr->jobsLeft <= 0)
+          return;
+     if (sourcePtr->jobs) {
+          job * jobPtr = &sourcePtr->jobs[sourcePtr->cfg->numberOfJobs - sourcePtr->jobsLeft];
+          if (jobPtr->sizeIndex < 0 || jobPtr->sizeIndex >= sourcePtr->cfg->numberOfProcessSizes
+               || jobPtr->serviceTime <= 0 || jobPtr->arrivalTime < sourcePtr->next.arrivalTime
+               || jobPtr->arrivalTime > sourcePtr->trialTicks) {
+               printf("ERROR JOB %d OF THE WORKLOAD FILE IS CORRUPT\n", jobPtr->pid);
+               exit(1);
           }
-          memPtr = memPtr->nextPtr;
+          sourcePtr->next = *jobPtr;
+          return;
      }
-     return memPtr;
+     double gap = 1.0 - pow(rngUniform(&sourcePtr->stream), 1.0 / sourcePtr->jobsLeft);
+     sourcePtr->arrivalFraction += (1.0 - sourcePtr->arrivalFraction) * gap;
+
+     job * jobPtr = &sourcePtr->next;
+     jobPtr->pid = sourcePtr->cfg->numberOfJobs - sourcePtr->jobsLeft;
+     jobPtr->arrivalTime = sourcePtr->arrivalFraction * sourcePtr->trialTicks;
+     jobPtr->serviceTime = (rngBelow(&sourcePtr->stream, 5) + 1) * 10;
+     jobPtr->sizeIndex = randomProcessSize(sourcePtr->cfg, &sourcePtr->stream);
+     jobPtr->seed = rngNext(&sourcePtr->stream);
 }
 
-// brings in a page from the disk to the memory to the first free page in memory
-// returns 0 if page was already in memory, 1 otherwise
-int pageIn(page * pagePtr, memory * memPtr, int time) {
-     if (pagePtr->inMemory) {
-          return 0;
+// starts the workload's job stream and draws its first job
+void initJobSource(jobSource * sourcePtr, config * cfg, int workloadNum) {
+     sourcePtr->cfg = cfg;
+     rngSeed(&sourcePtr->stream, cfg->seed, workloadNum);
+     sourcePtr->jobsLeft = cfg->numberOfJobs + 1;
+     sourcePtr->trialTicks = cfg->trialSeconds * TICKS_PER_SECOND;
+     sourcePtr->arrivalFraction = 0.0;
+     sourcePtr->jobs = NULL;
+     if (cfg->workloadsPtr)
+          sourcePtr->jobs = cfg->workloadsPtr->jobs + (long long)workloadNum * cfg->numberOfJobs;
+     sourcePtr->next.arrivalTime = 0.0;
+     drawNextJob(sourcePtr);
+}
+
+// writes the jobs of every workload the configuration generates to a workload file
+void saveWorkloads(config * cfg) {
+     FILE * file = fopen(cfg->saveWorkloadsPath, "wb");
+     if (!file) {
+          printf("ERROR OPENING WORKLOAD FILE %s\n", cfg->saveWorkloadsPath);
+          exit(1);
      }
+     workloadHeader header;
+     memset(&header, 0, sizeof(header));
+     memcpy(header.magic, WORKLOAD_MAGIC, sizeof(WORKLOAD_MAGIC));
+     header.version = WORKLOAD_VERSION;
+     header.jobSize = sizeof(job);
+     header.numberOfWorkloads = cfg->numberOfWorkloads;
+     header.numberOfJobs = cfg->numberOfJobs;
+     header.trialSeconds = cfg->trialSeconds;
+     header.numberOfProcessSizes = cfg->numberOfProcessSizes;
+     memcpy(header.processSizes, cfg->processSizes, sizeof(header.processSizes));
+     int failed = fwrite(&header, sizeof(header), 1, file) != 1;
 
-     memPtr = firstFreePage (memPtr);
-     if(memPtr){
-          memPtr->pagePtr = pagePtr;
-          memPtr->busy = 1;
-          pagePtr->inMemory = 1;
-          pagePtr->timePagedIn = time;
-          pagePtr->physPageID = memPtr->memID; //set the physical page ID
+     int workloadNum;
+     for (workloadNum = 0; workloadNum < cfg->numberOfWorkloads && !failed; ++workloadNum) {
+          jobSource source;
+          initJobSource(&source, cfg, workloadNum);
+          for (; source.jobsLeft > 0 && !failed; drawNextJob(&source))
+               failed = fwrite(&source.next, sizeof(job), 1, file) != 1;
      }
-     return 1;
+     if (fclose(file) != 0 || failed) {
+          printf("ERROR WRITING WORKLOAD FILE %s\n", cfg->saveWorkloadsPath);
+          exit(1);
+     }
+     printf("Saved %d workloads of %d jobs into %s\n", cfg->numberOfWorkloads, cfg->numberOfJobs,
+          cfg->saveWorkloadsPath);
 }
 
-// removes a page from memory
-// returns 1 if page found and removed, 0 otherwise
-int pageOut(page * pagePtr, memory * memPtr, int time) {
-     while(memPtr) {
-          if(memPtr->busy && memPtr->pagePtr == pagePtr) {
-               // page found in memory
-               memPtr->busy = 0;
-               memPtr->pagePtr->inMemory = 0;
-               memPtr->pagePtr->timeLastReferenced = 0;
-               memPtr->pagePtr->referenceCount = 0;
-               memPtr->pagePtr->physPageID = -1; //reset the physical page ID
-               return 1;
+// maps a workload file read-only and makes the configuration run its workloads, whose number,
+// jobs, run length and process sizes the file fixes; the mapping stays until the program exits
+void loadWorkloads(config * cfg) {
+     static mappedWorkloads loaded;
+     mappedWorkloads * workloadsPtr = &loaded;
+     int fd = open(cfg->workloadsPath, O_RDONLY);
+     struct stat st;
+     if (fd < 0 || fstat(fd, &st) != 0) {
+          printf("ERROR OPENING WORKLOAD FILE %s\n", cfg->workloadsPath);
+          exit(1);
+     }
+     if ((size_t)st.st_size < sizeof(workloadHeader)) {
+          printf("ERROR WORKLOAD FILE %s IS TRUNCATED\n", cfg->workloadsPath);
+          exit(1);
+     }
+     workloadsPtr->length = st.st_size;
+     void * base = mmap(NULL, workloadsPtr->length, PROT_READ, MAP_PRIVATE, fd, 0);
+     close(fd);
+     if (base == MAP_FAILED) {
+          printf("ERROR MAPPING WORKLOAD FILE %s\n", cfg->workloadsPath);
+          exit(1);
+     }
+
+     workloadsPtr->header = base;
+     workloadsPtr->jobs = (job *)((char *)base + sizeof(workloadHeader));
+     workloadHeader * header = workloadsPtr->header;
+     if (memcmp(header->magic, WORKLOAD_MAGIC, sizeof(WORKLOAD_MAGIC)) != 0 || header->version != WORKLOAD_VERSION
+          || header->jobSize != sizeof(job) || header->numberOfWorkloads <= 0 || header->numberOfJobs <= 0
+          || header->trialSeconds <= 0 || header->numberOfProcessSizes <= 0
+          || header->numberOfProcessSizes > MAX_PROCESS_SIZES
+          || sizeof(workloadHeader) + (double)header->numberOfWorkloads * header->numberOfJobs * sizeof(job)
+               > workloadsPtr->length) {
+          printf("ERROR %s IS NOT A VALID WORKLOAD FILE\n", cfg->workloadsPath);
+          exit(1);
+     }
+     int i;
+     for (i = 0; i < header->numberOfProcessSizes; ++i) {
+          if (header->processSizes[i] < MIN_PROCESS_PAGES) {
+               printf("ERROR %s IS NOT A VALID WORKLOAD FILE\n", cfg->workloadsPath);
+               exit(1);
           }
-          memPtr = memPtr->nextPtr;
      }
-     return 0;
+     cfg->numberOfWorkloads = header->numberOfWorkloads;
+     cfg->numberOfJobs = header->numberOfJobs;
+     cfg->trialSeconds = header->trialSeconds;
+     cfg->numberOfProcessSizes = header->numberOfProcessSizes;
+     memcpy(cfg->processSizes, header->processSizes, sizeof(cfg->processSizes));
+     cfg->workloadsPtr = workloadsPtr;
 }
 
-// updates metadata for referencing a page
-void referencePage(process * procPtr, page * pagePtr, memory * memPtr, int time) { 
-     pagePtr->timeLastReferenced = time;
-     pagePtr->referenceCount += 1;
-     procPtr->pageLastReferenced = pagePtr;
-     --DEBUG_print_references;
+// seeds the process' private RNG streams from its seed
+void seedProcessStreams(process * procPtr) {
+     rngSeed(&procPtr->referenceStream, procPtr->seed, STREAM_REFERENCES);
+     rngSeed(&procPtr->victimStream, procPtr->seed, STREAM_VICTIMS);
 }
 
-// returns pointer of the most recently referenced page
-page * previouslyReferencedPage(process * procPtr) {
-     return procPtr->pageLastReferenced;
+// resets a new or reused process to one that has not run yet, its allocations are kept
+void initProcess(process * procPtr, int pid, double arrivalTime, int serviceTime, unsigned long long seed) {
+     procPtr->pid = pid;
+     procPtr->arrivalTime = arrivalTime;
+     procPtr->serviceTime = serviceTime;
+     procPtr->firstRunTime = -1;
+     procPtr->hitCount = 0;
+     procPtr->missCount = 0;
+     procPtr->seed = seed;
+     seedProcessStreams(procPtr);
+     initPageTable(procPtr);
+     clearVictimState(&procPtr->victims);
+     procPtr->suspendedAt = -1;
+     procPtr->suspendedTicks = 0;
+     procPtr->completionSlot = -1;
+     procPtr->workingSetSize = 0;
+     procPtr->windowFaults = 0;
+     procPtr->numberOfReferences = 0;
+     procPtr->referencesMade = 0;
+     procPtr->lastStep = 0;
+     procPtr->blockedUntil = -1;
+     procPtr->shardPtr = NULL;
+#if METRICS_ENABLED
+     memset(procPtr->faultLatency, 0, sizeof(procPtr->faultLatency));
+#endif
+     procPtr->pageLastReferenced = NULL;
+     procPtr->nextPtr = NULL;
+     procPtr->nextLane = NULL;
 }
 
-// generates a random page to reference
-page * generateReference(process * procPtr, int time) {
-     page * lastReferenced = previouslyReferencedPage(procPtr);
-     int newReferencePageID = lastReferenced->pageID;
-     int localityReferenceChance = rand() % 100;
-     page * pageToReference = procPtr->pagePtr;
+// allocates a process that has not run yet together with its page table and victim structures
+// all of them are carved back to back from the arena so a process and its pages share cache lines
+process * createProcess(int pid, double arrivalTime, int serviceTime, int numberOfPages, unsigned long long seed,
+     arena * arenaPtr) {
+     process * procPtr = arenaAlloc(arenaPtr, sizeof(process));
+     procPtr->numberOfPages = numberOfPages;
+     procPtr->pageTable = arenaAlloc(arenaPtr, sizeof(page) * numberOfPages);
+     initVictimState(&procPtr->victims, numberOfPages, 0, arenaPtr);
+     procPtr->window = NULL;
+     procPtr->windowUses = NULL;
+     procPtr->nextUseDelta = NULL;
+     procPtr->nextUseCapacity = 0;
+     procPtr->sizeIndex = -1;
+     procPtr->localityPercent = DEFAULT_LOCALITY_PERCENT;
+     initProcess(procPtr, pid, arrivalTime, serviceTime, seed);
+     return procPtr;
+}
 
-     if (localityReferenceChance <= 69) {
-          int localityDifference = rand() % 3;
-          switch (localityDifference) {
-               case 0:
-                    newReferencePageID = (lastReferenced->pageID + 1) % procPtr->numberOfPages;
-                    break;
-               case 1:
-                    newReferencePageID = (lastReferenced->pageID - 1) % procPtr->numberOfPages;
-                    if (newReferencePageID < 0)
-                         newReferencePageID += procPtr->numberOfPages;
-                    break;
-               case 2:
-                    break;
-               default:
-                    printf("ERROR GENERATING REFERENCE\n");
-                    exit(1);
-          }
+// the shard with the most free frames, the lowest numbered one on a tie
+frameShard * roomiestShard(ram * ramPtr) {
+     frameShard * bestPtr = &ramPtr->shards[0];
+     int i;
+     for (i = 1; i < ramPtr->numberOfShards; ++i) {
+          if (ramPtr->shards[i].allocator.freeFrameCount > bestPtr->allocator.freeFrameCount)
+               bestPtr = &ramPtr->shards[i];
      }
+     return bestPtr;
+}
 
+// turns the job into a process of the memory's lane, reusing a finished process of the same size
+// so a run of any number of jobs only ever allocates as many processes as run at the same time
+process * acquireProcess(ram * ramPtr, job * jobPtr, config * cfg) {
+     process * procPtr = ramPtr->spareProcesses[jobPtr->sizeIndex];
+     if (procPtr) {
+          ramPtr->spareProcesses[jobPtr->sizeIndex] = procPtr->nextPtr;
+          initProcess(procPtr, jobPtr->pid, jobPtr->arrivalTime, jobPtr->serviceTime, jobPtr->seed);
+     }
      else {
-          int offsetBetweenPages = newReferencePageID - lastReferenced->pageID;
-          while ((offsetBetweenPages < 2) && (offsetBetweenPages > -2)) {
-               newReferencePageID = (lastReferenced->pageID + rand()) % procPtr->numberOfPages;
-               offsetBetweenPages = newReferencePageID - lastReferenced->pageID;
-          }
+          procPtr = createProcess(jobPtr->pid, jobPtr->arrivalTime, jobPtr->serviceTime,
+               cfg->processSizes[jobPtr->sizeIndex], jobPtr->seed, ramPtr->arenaPtr);
+          procPtr->sizeIndex = jobPtr->sizeIndex;
      }
+     procPtr->localityPercent = cfg->localityPercent;
+     if (ramPtr->shards)
+          procPtr->shardPtr = roomiestShard(ramPtr);
+     return procPtr;
+}
 
+// hands a finished process back to its memory for reuse
+void releaseProcess(process * procPtr, ram * ramPtr) {
+     procPtr->nextPtr = ramPtr->spareProcesses[procPtr->sizeIndex];
+     ramPtr->spareProcesses[procPtr->sizeIndex] = procPtr;
+}
+
+// returns total number of free pages in memory
+int numberOfFreePages (ram * ramPtr) {
+     if (!ramPtr->shards)
+          return ramPtr->allocator.freeFrameCount;
+     int total = 0;
      int i;
-     for (i = 0; i < newReferencePageID; ++i)
-          pageToReference = pageToReference->nextPtr;
+     for (i = 0; i < ramPtr->numberOfShards; ++i)
+          total += ramPtr->shards[i].allocator.freeFrameCount;
+     return total;
+}
 
-     return pageToReference;
+// returns the number of free pages a fault of the process can take without replacing
+int freePagesFor(process * procPtr, ram * ramPtr) {
+     return procPtr->shardPtr ? procPtr->shardPtr->allocator.freeFrameCount : numberOfFreePages(ramPtr);
 }
 
-page * pageReplaceLRU(process * procPtr, memory * memPtr, int time, policy desiredPolicy) {
-     page * LRU = NULL; 
-     while (memPtr) {
-          if (memPtr->busy && (memPtr->pagePtr->pid == procPtr->pid)) {
-               if (!LRU) {
-                    LRU = memPtr->pagePtr;
-               } else if (memPtr->pagePtr->timeLastReferenced < LRU->timeLastReferenced) {
-                    LRU = memPtr->pagePtr;
-               }
-          }
-          memPtr = memPtr->nextPtr;
-     }
-     return LRU;
+// returns the number of frames a fault of the process can take, those of its shard in sharded memory
+int framesFor(process * procPtr, ram * ramPtr) {
+     frameShard * shardPtr = procPtr->shardPtr;
+     if (!shardPtr)
+          return ramPtr->numberOfFrames;
+     int endFrame = shardPtr + 1 < ramPtr->shards + ramPtr->numberOfShards ? shardPtr[1].firstFrame : ramPtr->numberOfFrames;
+     return endFrame - shardPtr->firstFrame;
 }
 
-page * pageReplaceLFU(process * procPtr, memory * memPtr, int time, policy desiredPolicy) {
-     page * LFU = NULL; 
-     while (memPtr) {
-          if (memPtr->busy && (memPtr->pagePtr->pid == procPtr->pid)) {
-               if (!LFU) {
-                    LFU = memPtr->pagePtr;
-               } else if (memPtr->pagePtr->referenceCount < LFU->referenceCount) {
-                    LFU = memPtr->pagePtr;
-               }
-          }
-          memPtr = memPtr->nextPtr;
+// the free frames a process takes its frames from, and the memID of their first one
+frameAllocator * frameSourceOf(process * procPtr, ram * ramPtr, int * firstFramePtr) {
+     if (procPtr->shardPtr) {
+          *firstFramePtr = procPtr->shardPtr->firstFrame;
+          return &procPtr->shardPtr->allocator;
      }
-     return LFU;
+     *firstFramePtr = 0;
+     return &ramPtr->allocator;
 }
 
-page * pageReplaceMFU(process * procPtr, memory * memPtr, int time, policy desiredPolicy) {
-     page * MFU = NULL; 
-     while (memPtr) {
-          if (memPtr->busy && (memPtr->pagePtr->pid == procPtr->pid)) {
-               if (!MFU) {
-                    MFU = memPtr->pagePtr;
-               } else if (memPtr->pagePtr->referenceCount > MFU->referenceCount) {
-                    MFU = memPtr->pagePtr;
-               }
-          }
-          memPtr = memPtr->nextPtr;
-     }
-     return MFU;
+// returns the number of pages in memory that belong to the specified process
+int numberOfProcessPagesInMemory(int pid, ram * ramPtr) {
+     int count = 0;
+     int i;
+     for (i = 0; i < ramPtr->numberOfFrames; ++i)
+          count += (ramPtr->meta.owner[i] == pid);
+     return count;
 }
 
-page * pageReplaceFIFO(process * procPtr, memory * memPtr, int time, policy desiredPolicy) {
-     page * FIFO = NULL; 
-     while (memPtr) {
-          if (memPtr->busy && (memPtr->pagePtr->pid == procPtr->pid)) {
-               if (!FIFO) {
-                    FIFO = memPtr->pagePtr;
-               } else if (memPtr->pagePtr->timePagedIn < FIFO->timePagedIn) {
-                    FIFO = memPtr->pagePtr;
-               }
+// masked scans over one per-frame metadata array, run by the FIFO, LRU, LFU and MFU victim scans of
+// --victim-scan and by the -b layout benchmark. Among the frames owned by pid, or every busy frame if
+// pid is negative, find the frame with the smallest key, the lowest frame on ties, or -1 if none
+// match. flip is 0 for the smallest key or -1 for the largest, since ~a < ~b exactly when a > b
+// a frame matches when (owners[i] == target) differs from invert, target is -1 with invert set for pid < 0
+int frameScanScalar(int * keys, int * owners, int numberOfFrames, int pid, int flip) {
+     int target = pid < 0 ? -1 : pid;
+     int invert = pid < 0;
+     int best = -1;
+     int bestKey = 0;
+     int i;
+     for (i = 0; i < numberOfFrames; ++i) {
+          if (((owners[i] == target) != invert) && (best < 0 || (keys[i] ^ flip) < bestKey)) {
+               best = i;
+               bestKey = keys[i] ^ flip;
           }
-          memPtr = memPtr->nextPtr;
      }
-     return FIFO;
+     return best;
 }
 
-page * pageReplaceRANDOM(process * procPtr, memory * memPtr, int time, policy desiredPolicy) {
-     page * RANDOM = procPtr->pagePtr;
-     int count = 0;
+#if defined(__x86_64__) || defined(__i386__)
+// the vector kernels take two passes: the masked minimum of the flipped keys, then the first
+// matching frame holding it, which keeps the scalar tie-breaking exactly
 
-     while (RANDOM) {
-          if (RANDOM->inMemory)
-               ++count;
-          RANDOM = RANDOM->nextPtr;
+__attribute__((target("sse4.1")))
+int frameScanSSE4(int * keys, int * owners, int numberOfFrames, int pid, int flip) {
+     __m128i target = _mm_set1_epi32(pid < 0 ? -1 : pid);
+     __m128i invert = _mm_set1_epi32(pid < 0 ? -1 : 0);
+     __m128i flipVec = _mm_set1_epi32(flip);
+     __m128i fill = _mm_set1_epi32(INT_MAX);
+     __m128i best = fill;
+     int i;
+     for (i = 0; i + 4 <= numberOfFrames; i += 4) {
+          __m128i mask = _mm_xor_si128(_mm_cmpeq_epi32(_mm_loadu_si128((__m128i *)(owners + i)), target), invert);
+          __m128i key = _mm_xor_si128(_mm_loadu_si128((__m128i *)(keys + i)), flipVec);
+          best = _mm_min_epi32(best, _mm_blendv_epi8(fill, key, mask));
+     }
+     best = _mm_min_epi32(best, _mm_shuffle_epi32(best, _MM_SHUFFLE(1, 0, 3, 2)));
+     best = _mm_min_epi32(best, _mm_shuffle_epi32(best, _MM_SHUFFLE(2, 3, 0, 1)));
+     int bestKey = _mm_cvtsi128_si32(best);
+     int tail = i;
+     for (; i < numberOfFrames; ++i) {
+          if (((owners[i] == (pid < 0 ? -1 : pid)) != (pid < 0)) && (keys[i] ^ flip) < bestKey)
+               bestKey = keys[i] ^ flip;
      }
 
-     RANDOM = procPtr->pagePtr;
-     int randomCount = (rand() % count) + 1;
+     __m128i bestVec = _mm_set1_epi32(bestKey);
+     for (i = 0; i < tail; i += 4) {
+          __m128i mask = _mm_xor_si128(_mm_cmpeq_epi32(_mm_loadu_si128((__m128i *)(owners + i)), target), invert);
+          __m128i key = _mm_xor_si128(_mm_loadu_si128((__m128i *)(keys + i)), flipVec);
+          int hits = _mm_movemask_ps(_mm_castsi128_ps(_mm_and_si128(mask, _mm_cmpeq_epi32(key, bestVec))));
+          if (hits)
+               return i + __builtin_ctz(hits);
+     }
+     for (; i < numberOfFrames; ++i) {
+          if (((owners[i] == (pid < 0 ? -1 : pid)) != (pid < 0)) && (keys[i] ^ flip) == bestKey)
+               return i;
+     }
+     return -1;
+}
 
-     while (RANDOM) {
-          if (RANDOM->inMemory == 1) {
-               randomCount -= 1;
-               if (randomCount == 0)
-                    break;
-          }
-          RANDOM = RANDOM->nextPtr;
+__attribute__((target("avx2")))
+int frameScanAVX2(int * keys, int * owners, int numberOfFrames, int pid, int flip) {
+     __m256i target = _mm256_set1_epi32(pid < 0 ? -1 : pid);
+     __m256i invert = _mm256_set1_epi32(pid < 0 ? -1 : 0);
+     __m256i flipVec = _mm256_set1_epi32(flip);
+     __m256i fill = _mm256_set1_epi32(INT_MAX);
+     __m256i best = fill;
+     int i;
+     for (i = 0; i + 8 <= numberOfFrames; i += 8) {
+          __m256i mask = _mm256_xor_si256(_mm256_cmpeq_epi32(_mm256_loadu_si256((__m256i *)(owners + i)), target), invert);
+          __m256i key = _mm256_xor_si256(_mm256_loadu_si256((__m256i *)(keys + i)), flipVec);
+          best = _mm256_min_epi32(best, _mm256_blendv_epi8(fill, key, mask));
+     }
+     __m128i half = _mm_min_epi32(_mm256_castsi256_si128(best), _mm256_extracti128_si256(best, 1));
+     half = _mm_min_epi32(half, _mm_shuffle_epi32(half, _MM_SHUFFLE(1, 0, 3, 2)));
+     half = _mm_min_epi32(half, _mm_shuffle_epi32(half, _MM_SHUFFLE(2, 3, 0, 1)));
+     int bestKey = _mm_cvtsi128_si32(half);
+     int tail = i;
+     for (; i < numberOfFrames; ++i) {
+          if (((owners[i] == (pid < 0 ? -1 : pid)) != (pid < 0)) && (keys[i] ^ flip) < bestKey)
+               bestKey = keys[i] ^ flip;
      }
 
-     return RANDOM;
+     __m256i bestVec = _mm256_set1_epi32(bestKey);
+     for (i = 0; i < tail; i += 8) {
+          __m256i mask = _mm256_xor_si256(_mm256_cmpeq_epi32(_mm256_loadu_si256((__m256i *)(owners + i)), target), invert);
+          __m256i key = _mm256_xor_si256(_mm256_loadu_si256((__m256i *)(keys + i)), flipVec);
+          int hits = _mm256_movemask_ps(_mm256_castsi256_ps(_mm256_and_si256(mask, _mm256_cmpeq_epi32(key, bestVec))));
+          if (hits)
+               return i + __builtin_ctz(hits);
+     }
+     for (; i < numberOfFrames; ++i) {
+          if (((owners[i] == (pid < 0 ? -1 : pid)) != (pid < 0)) && (keys[i] ^ flip) == bestKey)
+               return i;
+     }
+     return -1;
 }
 
-page * pageReplace(process * procPtr, memory * memPtr, int time, policy desiredPolicy) {
-     page * pageToReplace = NULL;
-     switch (desiredPolicy) {
-          case LRU:
-               pageToReplace = pageReplaceLRU(procPtr, memPtr, time, desiredPolicy);
-               break;
-          case LFU:
-               pageToReplace = pageReplaceLFU(procPtr, memPtr, time, desiredPolicy);
-               break;
-          case MFU:
-               pageToReplace = pageReplaceMFU(procPtr, memPtr, time, desiredPolicy);
-               break;
-          case FIFO:
-               pageToReplace = pageReplaceFIFO(procPtr, memPtr, time, desiredPolicy);
-               break;
-          case RANDOM:
-               pageToReplace = pageReplaceRANDOM(procPtr, memPtr, time, desiredPolicy);
-               break;
-          default:
-               printf("ERROR INVALID POLICY\n");
-               exit(1);
+__attribute__((target("avx512f")))
+int frameScanAVX512(int * keys, int * owners, int numberOfFrames, int pid, int flip) {
+     __m512i target = _mm512_set1_epi32(pid < 0 ? -1 : pid);
+     __mmask16 invert = pid < 0 ? 0xFFFF : 0;
+     __m512i flipVec = _mm512_set1_epi32(flip);
+     __m512i best = _mm512_set1_epi32(INT_MAX);
+     int i;
+     for (i = 0; i + 16 <= numberOfFrames; i += 16) {
+          __mmask16 mask = _mm512_cmpeq_epi32_mask(_mm512_loadu_si512(owners + i), target) ^ invert;
+          __m512i key = _mm512_xor_si512(_mm512_loadu_si512(keys + i), flipVec);
+          best = _mm512_mask_min_epi32(best, mask, best, key);
+     }
+     int bestKey = _mm512_reduce_min_epi32(best);
+     int tail = i;
+     for (; i < numberOfFrames; ++i) {
+          if (((owners[i] == (pid < 0 ? -1 : pid)) != (pid < 0)) && (keys[i] ^ flip) < bestKey)
+               bestKey = keys[i] ^ flip;
      }
-     return(pageToReplace);
-}
 
-// checks if the process has started running by the specified time
-int processStarted(process * procPtr, int time) {
-     return ((procPtr->firstRunTime != -1) && (procPtr->firstRunTime <= time));
+     __m512i bestVec = _mm512_set1_epi32(bestKey);
+     for (i = 0; i < tail; i += 16) {
+          __mmask16 mask = _mm512_cmpeq_epi32_mask(_mm512_loadu_si512(owners + i), target) ^ invert;
+          __m512i key = _mm512_xor_si512(_mm512_loadu_si512(keys + i), flipVec);
+          __mmask16 hits = _mm512_mask_cmpeq_epi32_mask(mask, key, bestVec);
+          if (hits)
+               return i + __builtin_ctz(hits);
+     }
+     for (; i < numberOfFrames; ++i) {
+          if (((owners[i] == (pid < 0 ? -1 : pid)) != (pid < 0)) && (keys[i] ^ flip) == bestKey)
+               return i;
+     }
+     return -1;
 }
+#endif
 
-// checks if the process is complete
-int processCompleted(process * procPtr, int time) {
-     return (time >= (procPtr->firstRunTime + procPtr->serviceTime));
-}
+typedef int (*frameScanKernel)(int * keys, int * owners, int numberOfFrames, int pid, int flip);
 
-void printMemoryMap(memory * memPtr) {
-     printf("Memory map\n");
-     int counter = 0;
-     int entriesPerLine = 20;
-     while (memPtr) {
-          if (memPtr->busy) {
-               printf("%03d ", memPtr->pagePtr->pid);
-          }
-          else {
-               printf("... ");
-          }          
-          memPtr = memPtr->nextPtr;
+frameScanKernel frameScan = frameScanScalar;  // kernel used by every frame scan, chosen once in main
+char * frameScanName = "scalar";
 
-          if (counter == entriesPerLine - 1)
-               printf("\n");
-          counter = ((counter + 1) % entriesPerLine);
+// picks the widest kernel the CPU supports, or the one named, e.g. "sse4", "avx2", "avx512" or "scalar"
+void selectFrameScanKernel(char * name) {
+     frameScan = frameScanScalar;
+     frameScanName = "scalar";
+#if defined(__x86_64__) || defined(__i386__)
+     __builtin_cpu_init();
+     int automatic = (name == NULL);
+     if ((automatic || strcmp(name, "avx512") == 0) && __builtin_cpu_supports("avx512f")) {
+          frameScan = frameScanAVX512;
+          frameScanName = "avx512";
      }
-
-     printf("\n");
-}
-
-// initiates process by referencing their page 0 
-void startProcess(process * procPtr, memory * memPtr, int time) {
-     if (DEBUG_print_swaps && DEBUG_print_references > 0) {
-          printf("\nSWAPPING time: %d.%03d, proc: %3d, Enter, size: %2d, service: %d seconds\n", 
-               (time*100)/1000, (time*100)%1000, procPtr->pid, procPtr->numberOfPages, procPtr->serviceTime/10);
-          printMemoryMap(memPtr);
+     else if ((automatic || strcmp(name, "avx2") == 0) && __builtin_cpu_supports("avx2")) {
+          frameScan = frameScanAVX2;
+          frameScanName = "avx2";
      }
-     procPtr->firstRunTime = time;
-     pageIn(procPtr->pagePtr, memPtr, time);
-     referencePage(procPtr, procPtr->pagePtr, memPtr, time);
-     procPtr->missCount += 1;
-     if (DEBUG_print_references > 0) {
-          printf("REF MISS time: %d.%03d, proc: %3d, ref page: %2d, frame: %2d\n",
-               (time*100)/1000, (time*100)%1000, procPtr->pid, procPtr->pagePtr->pageID, procPtr->pagePtr->physPageID);
+     else if ((automatic || strcmp(name, "sse4") == 0) && __builtin_cpu_supports("sse4.1")) {
+          frameScan = frameScanSSE4;
+          frameScanName = "sse4";
+     }
+#endif
+     if (name && strcmp(name, frameScanName) != 0) {
+          printf("ERROR SCAN KERNEL %s IS NOT AVAILABLE\n", name);
+          exit(1);
      }
 }
 
-// stops process and removes its pages from memory, returns the number of pages removed
-int stopProcess(process * procPtr, memory * memPtr, int time) { 
-     int count = 0;
-     memory * memHead = memPtr;
-     while(memPtr) {
-          if(memPtr->pagePtr && (memPtr->pagePtr->pid == procPtr->pid)) {
-               memPtr->busy = 0;
-               memPtr->pagePtr->inMemory = 0;
-               ++count;
-          }
-          memPtr = memPtr->nextPtr;
-     }
-     
-     if(DEBUG_print_swaps && DEBUG_print_references > 0) {
-          printf("\nSWAPPING time: %d.%03d, proc: %3d,  Exit, size: %2d, service: %d seconds\n", 
-               (time*100)/1000, (time*100)%1000, procPtr->pid, procPtr->numberOfPages, procPtr->serviceTime/10);
-          printMemoryMap(memHead);
-     }
+int frameArgMin(int * keys, int * owners, int numberOfFrames, int pid) {
+     return frameScan(keys, owners, numberOfFrames, pid, 0);
+}
 
-     return count;
+int frameArgMax(int * keys, int * owners, int numberOfFrames, int pid) {
+     return frameScan(keys, owners, numberOfFrames, pid, -1);
 }
 
-// brings in jobs that have arrived into memory if there is room for them
-void bringInWaitingJobs(process * procPtr, memory * memPtr, int time) {
-     while (procPtr) {
-          if ((procPtr->arrivalTime < (float)time) && (procPtr->firstRunTime == -1) && (numberOfFreePages(memPtr) >= 4)){
-               startProcess(procPtr, memPtr, time);
-          }
-          procPtr = procPtr->nextPtr;
-     }
+// returns memory address of the first free page the process can take
+memory * firstFreePage(process * procPtr, ram * ramPtr) {
+     int firstFrame;
+     int frame = lowestFreeFrame(frameSourceOf(procPtr, ramPtr, &firstFrame));
+     if (frame < 0)
+          return NULL;
+     return &ramPtr->frames[firstFrame + frame];
 }
 
-// takes all jobs that are have run for their service time out of memory
-void kickOutCompletedJobs(process * procPtr, memory * memPtr, int time) {
-     while (procPtr) {
-          if(processStarted(procPtr, time) && processCompleted(procPtr, time) && 
-               !processCompleted(procPtr, time-1)) {  
-               stopProcess(procPtr, memPtr, time);
-          }
-          procPtr = procPtr->nextPtr;
-     }
+// returns the frame holding the page, or NULL if the page is not in memory
+memory * findPageInMemory(page * pagePtr, ram * ramPtr) {
+     if (!pagePtr->inMemory)
+          return NULL;
+     return &ramPtr->frames[pagePtr->physPageID];
 }
-          
-int numberOfJobsRun(process * procPtr) {
-     int counter = 0;
-     while(procPtr) {
-          if(procPtr->firstRunTime != -1) {
-               ++counter;
-          }
-          procPtr = procPtr->nextPtr;
-     }
-     return counter;
+
+// key the FIFO and LRU resident lists are ordered by
+int residentOrderKey(page * pagePtr, policy desiredPolicy) {
+     if (desiredPolicy == FIFO)
+          return pagePtr->timePagedIn;
+     return pagePtr->timeLastReferenced;
 }
 
-int totalNumberOfHits(process * procPtr) {
-     int counter = 0;
-     while(procPtr) {
-          counter += procPtr->hitCount;
-          procPtr = procPtr->nextPtr;
-     }
-     return counter;
+// returns 1 if page a is a better FIFO/LRU victim than page b, ties go to the lowest frame
+int residentBefore(page * a, page * b, policy desiredPolicy) {
+     int keyA = residentOrderKey(a, desiredPolicy);
+     int keyB = residentOrderKey(b, desiredPolicy);
+     return (keyA < keyB) || (keyA == keyB && a->physPageID < b->physPageID);
 }
 
-int totalNumberOfMisses(process * procPtr) {
-     int counter = 0;
-     while(procPtr) {
-          counter += procPtr->missCount;
-          procPtr = procPtr->nextPtr;
-     }
-     return counter;
+// links the page into the list right after prevPtr, or at the head if prevPtr is NULL
+void pageListInsertAfter(victimState * statePtr, policyList listID, page * prevPtr, page * pagePtr) {
+     pageList * listPtr = &statePtr->policyLists[listID];
+     pagePtr->prevResident = prevPtr;
+     pagePtr->nextResident = prevPtr ? prevPtr->nextResident : listPtr->head;
+     if (pagePtr->nextResident)
+          pagePtr->nextResident->prevResident = pagePtr;
+     else
+          listPtr->tail = pagePtr;
+     if (prevPtr)
+          prevPtr->nextResident = pagePtr;
+     else
+          listPtr->head = pagePtr;
+     pagePtr->policyList = listID;
+     ++listPtr->size;
 }
 
-void printVisualDivider() {
-     int i = 0;
-     printf("\n");
-     for (i = 0; i < 80; ++i) 
-          printf("=");   // this is just for a clearer section break
-     printf("\n");
+void pageListAppend(victimState * statePtr, policyList listID, page * pagePtr) {
+     pageListInsertAfter(statePtr, listID, statePtr->policyLists[listID].tail, pagePtr);
 }
 
-int main() {
-     //srand(time(NULL));
-     char * policyNames[5] = {"FIFO", "LRU", "LFU", "MFU", "RANDOM"};
-     DEBUG_print_references = 0;
-     DEBUG_print_swaps = 1;
-     srand(1337);
+void pageListRemove(victimState * statePtr, page * pagePtr) {
+     pageList * listPtr = &statePtr->policyLists[pagePtr->policyList];
+     if (pagePtr->prevResident)
+          pagePtr->prevResident->nextResident = pagePtr->nextResident;
+     else
+          listPtr->head = pagePtr->nextResident;
+     if (pagePtr->nextResident)
+          pagePtr->nextResident->prevResident = pagePtr->prevResident;
+     else
+          listPtr->tail = pagePtr->prevResident;
+     pagePtr->prevResident = NULL;
+     pagePtr->nextResident = NULL;
+     pagePtr->policyList = LIST_NONE;
+     --listPtr->size;
+}
 
-     memory * memHead = NULL;
-     process * procHead = NULL;
+// moves the page to the newest end of a list, taking it out of whichever list held it
+void pageListMoveToTail(victimState * statePtr, policyList listID, page * pagePtr) {
+     if (pagePtr->policyList != LIST_NONE)
+          pageListRemove(statePtr, pagePtr);
+     pageListAppend(statePtr, listID, pagePtr);
+}
 
-     int trialNum = 0;
-     for(trialNum = 0; trialNum < 25; ++trialNum) {
-          if(trialNum < 5) {
-               printVisualDivider();
-               printf("\nRUNNING POLICY: %s\n", policyNames[trialNum]);
-               DEBUG_print_references = 100;
-          }
-          else {
-               DEBUG_print_references = 0;
-          }
-
-          if(trialNum % 5 == 0) {
-               memHead = downloadRAM();
-               procHead = generateProcesses();
-          }
-
-          int time;
-          policy desiredPolicy = trialNum % 5;
-
-          for (time = 0; time < 600; ++time) {
-               process * procPtr = procHead;
-
-               kickOutCompletedJobs(procHead, memHead, time);
-               bringInWaitingJobs(procHead, memHead, time);
-
-               procPtr = procHead;
-               while (procPtr) {
-                    if (processStarted(procPtr, time - 1) && !processCompleted(procPtr, time)) {
-                         //generate desired page
-                         page * desiredPage = generateReference(procPtr, time);
-                         //if desired page is not in memory
-                         if (desiredPage->inMemory == 0) {
-                              if (numberOfFreePages(memHead) <= 0) {
-                                   // MISS needs replacement
-                                   procPtr->missCount += 1;
-                                   page * pageToRemove = pageReplace(procPtr, memHead, time, desiredPolicy);
-                                   pageOut(pageToRemove, memHead, time);
-                                   pageIn(desiredPage, memHead, time);
-                                   if (DEBUG_print_references > 0) {
-                                        printf("REF MISS time: %d.%03d, proc: %3d, ref page: %2d, frame: %2d, page out: %2d\n",
-                                             (time*100)/1000, (time*100)%1000, procPtr->pid, desiredPage->pageID, 
-                                             desiredPage->physPageID, pageToRemove->pageID);
-                                   }
-                              }
-                              else {
-                                   // MISS with free pages
-                                   procPtr->missCount += 1;
-                                   pageIn(desiredPage, memHead, time);
-                                   if (DEBUG_print_references > 0) {
-                                        printf("REF MISS time: %d.%03d, proc: %3d, ref page: %2d, frame: %2d\n",
-                                             (time*100)/1000, (time*100)%1000, procPtr->pid, desiredPage->pageID, 
-                                             desiredPage->physPageID);
-                                   }
-                              }
-                         }
-                         else {
-                              // HIT
-                              procPtr->hitCount += 1;
-                              if (DEBUG_print_references > 0) {
-                                   printf("REF HIT  time: %d.%03d, proc: %3d, ref page: %2d, frame: %2d\n",
-                                        (time*100)/1000, (time*100)%1000, procPtr->pid, desiredPage->pageID, 
-                                        desiredPage->physPageID);     
-                              }
-                         }
-                         //actually reference the page
-                         referencePage(procPtr, desiredPage, memHead, time);
-                    }
-                    procPtr = procPtr->nextPtr;
-               }
-          } 
+// the LIRS queue of resident HIR pages is linked through its own links since its pages can also be on the stack
+void pageQueueAppend(victimState * statePtr, page * pagePtr) {
+     pageList * listPtr = &statePtr->policyLists[LIRS_QUEUE];
+     pagePtr->prevQueued = listPtr->tail;
+     pagePtr->nextQueued = NULL;
+     if (listPtr->tail)
+          listPtr->tail->nextQueued = pagePtr;
+     else
+          listPtr->head = pagePtr;
+     listPtr->tail = pagePtr;
+     pagePtr->queued = 1;
+     ++listPtr->size;
+}
 
-          trial_statistics[trialNum][0] = numberOfJobsRun(procHead);
-          trial_statistics[trialNum][1] = totalNumberOfHits(procHead);
-          trial_statistics[trialNum][2] = totalNumberOfMisses(procHead);          
+void pageQueueRemove(victimState * statePtr, page * pagePtr) {
+     pageList * listPtr = &statePtr->policyLists[LIRS_QUEUE];
+     if (pagePtr->prevQueued)
+          pagePtr->prevQueued->nextQueued = pagePtr->nextQueued;
+     else
+          listPtr->head = pagePtr->nextQueued;
+     if (pagePtr->nextQueued)
+          pagePtr->nextQueued->prevQueued = pagePtr->prevQueued;
+     else
+          listPtr->tail = pagePtr->prevQueued;
+     pagePtr->prevQueued = NULL;
+     pagePtr->nextQueued = NULL;
+     pagePtr->queued = 0;
+     --listPtr->size;
+}
 
-          resetMetadata(memHead, procHead);
-          if (trialNum % 5 == 5-1) {
-               freeProcesses(procHead);
-          } 
+// links the page into its sorted place in the FIFO/LRU resident list
+// new keys are normally the newest so the search starts at the tail, stale keys start at the head
+void residentListInsert(victimState * statePtr, page * pagePtr, policy desiredPolicy) {
+     pageList * listPtr = &statePtr->policyLists[LIST_RESIDENT];
+     page * prevPtr = NULL;
+     if (listPtr->head && !residentBefore(pagePtr, listPtr->head, desiredPolicy)) {
+          prevPtr = listPtr->tail;
+          while (residentBefore(pagePtr, prevPtr, desiredPolicy))
+               prevPtr = prevPtr->prevResident;
      }
-     freeMemory(memHead);
+     pageListInsertAfter(statePtr, LIST_RESIDENT, prevPtr, pagePtr);
+}
+
+// returns 1 if page a is a better LFU/MFU/OPT victim than page b, ties go to the lowest frame
+int heapBefore(page * a, page * b, policy desiredPolicy) {
+     if (desiredPolicy == OPT) {
+          if (a->nextUse != b->nextUse)
+               return a->nextUse > b->nextUse;
+     }
+     else if (a->referenceCount != b->referenceCount) {
+          if (desiredPolicy == LFU)
+               return a->referenceCount < b->referenceCount;
+          return a->referenceCount > b->referenceCount;
+     }
+     return a->physPageID < b->physPageID;
+}
+
+void heapSwap(victimState * statePtr, int i, int j) {
+     page * temp = statePtr->victimHeap[i];
+     statePtr->victimHeap[i] = statePtr->victimHeap[j];
+     statePtr->victimHeap[j] = temp;
+     statePtr->victimHeap[i]->heapIndex = i;
+     statePtr->victimHeap[j]->heapIndex = j;
+}
+
+void heapSiftUp(victimState * statePtr, int i, policy desiredPolicy) {
+     while (i > 0) {
+          int parent = (i - 1) / 2;
+          if (!heapBefore(statePtr->victimHeap[i], statePtr->victimHeap[parent], desiredPolicy))
+               break;
+          heapSwap(statePtr, i, parent);
+          i = parent;
+     }
+}
+
+void heapSiftDown(victimState * statePtr, int i, policy desiredPolicy) {
+     while (1) {
+          int best = i;
+          int left = 2 * i + 1;
+          int right = left + 1;
+          if (left < statePtr->victimHeapSize && heapBefore(statePtr->victimHeap[left], statePtr->victimHeap[best], desiredPolicy))
+               best = left;
+          if (right < statePtr->victimHeapSize && heapBefore(statePtr->victimHeap[right], statePtr->victimHeap[best], desiredPolicy))
+               best = right;
+          if (best == i)
+               break;
+          heapSwap(statePtr, i, best);
+          i = best;
+     }
+}
+
+void heapInsert(victimState * statePtr, page * pagePtr, policy desiredPolicy) {
+     int i = statePtr->victimHeapSize++;
+     statePtr->victimHeap[i] = pagePtr;
+     pagePtr->heapIndex = i;
+     heapSiftUp(statePtr, i, desiredPolicy);
+}
+
+void heapRemove(victimState * statePtr, page * pagePtr, policy desiredPolicy) {
+     int i = pagePtr->heapIndex;
+     int last = --statePtr->victimHeapSize;
+     pagePtr->heapIndex = -1;
+     if (i == last)
+          return;
+     statePtr->victimHeap[i] = statePtr->victimHeap[last];
+     statePtr->victimHeap[i]->heapIndex = i;
+     heapSiftUp(statePtr, i, desiredPolicy);
+     heapSiftDown(statePtr, statePtr->victimHeap[i]->heapIndex, desiredPolicy);
+}
+
+void residentTreeAdd(victimState * statePtr, int key, int delta) {
+     int i;
+     for (i = key + 1; i <= statePtr->treeSize; i += i & -i)
+          statePtr->residentTree[i] += delta;
+}
+
+// returns the key of the k-th resident page in key order, k counted from 1
+int residentTreeFind(victimState * statePtr, int k) {
+     int position = 0;
+     int step = 1;
+     while (step * 2 <= statePtr->treeSize)
+          step *= 2;
+     for (; step > 0; step /= 2) {
+          if (position + step <= statePtr->treeSize && statePtr->residentTree[position + step] < k) {
+               position += step;
+               k -= statePtr->residentTree[position];
+          }
+     }
+     return position;
+}
+
+// CLOCK: the resident list is a ring swept by the hand, a new page takes the place of the page the
+// hand just evicted, i.e. right behind the hand
+void clockTrackPage(victimState * statePtr, page * pagePtr) {
+     pagePtr->referenceBit = 0;
+     if (statePtr->clockHand)
+          pageListInsertAfter(statePtr, LIST_RESIDENT, statePtr->clockHand->prevResident, pagePtr);
+     else
+          pageListAppend(statePtr, LIST_RESIDENT, pagePtr);
+}
+
+void clockUntrackPage(victimState * statePtr, page * pagePtr) {
+     if (statePtr->clockHand == pagePtr)
+          statePtr->clockHand = pagePtr->nextResident;
+     pageListRemove(statePtr, pagePtr);
+}
+
+// 2Q: pages start in the A1in FIFO and are only promoted to the Am LRU when they fault again while
+// A1out still remembers them
+void twoQueueTrackPage(victimState * statePtr, page * pagePtr) {
+     if (pagePtr->policyList == TWOQ_A1OUT)
+          pageListMoveToTail(statePtr, TWOQ_AM, pagePtr);
+     else
+          pageListAppend(statePtr, TWOQ_A1IN, pagePtr);
+
+     pageList * outPtr = &statePtr->policyLists[TWOQ_A1OUT];
+     int outLimit = statePtr->residentCount * TWOQ_OUT_PERCENT / 100;
+     while (outPtr->size > (outLimit > 1 ? outLimit : 1))
+          pageListRemove(statePtr, outPtr->head);
+}
+
+void twoQueueUntrackPage(victimState * statePtr, page * pagePtr) {
+     if (pagePtr->policyList == TWOQ_A1IN)
+          pageListMoveToTail(statePtr, TWOQ_A1OUT, pagePtr);
+     else
+          pageListRemove(statePtr, pagePtr);
+}
+
+// ARC: T1 and T2 split the domain's frames between recency and frequency, the ghosts in B1 and B2
+// steer the split through arcTarget. Only as many ghosts as the domain can hold frames are kept for each
+// side, so the ghost lists fill while a process warms up and survive it giving up frames
+void arcTrackPage(victimState * statePtr, page * pagePtr) {
+     if (pagePtr->policyList == ARC_B1 || pagePtr->policyList == ARC_B2)
+          pageListMoveToTail(statePtr, ARC_T2, pagePtr);
+     else
+          pageListAppend(statePtr, ARC_T1, pagePtr);
+
+     pageList * lists = statePtr->policyLists;
+     int capacity = statePtr->arcCapacity;
+     while (lists[ARC_T1].size + lists[ARC_B1].size > capacity && lists[ARC_B1].size > 0)
+          pageListRemove(statePtr, lists[ARC_B1].head);
+     while (lists[ARC_B1].size + lists[ARC_B2].size > capacity) {
+          if (lists[ARC_B2].size > 0)
+               pageListRemove(statePtr, lists[ARC_B2].head);
+          else
+               pageListRemove(statePtr, lists[ARC_B1].head);
+     }
+}
+
+void arcUntrackPage(victimState * statePtr, page * pagePtr) {
+     if (pagePtr->policyList == ARC_T1)
+          pageListMoveToTail(statePtr, ARC_B1, pagePtr);
+     else
+          pageListMoveToTail(statePtr, ARC_B2, pagePtr);
+}
+
+// a miss on a ghost means the side it was evicted from deserved more frames
+void arcFaultPage(victimState * statePtr, page * pagePtr) {
+     pageList * lists = statePtr->policyLists;
+     int capacity = statePtr->arcCapacity;
+     if (pagePtr->policyList == ARC_B1) {
+          int delta = lists[ARC_B2].size / lists[ARC_B1].size;
+          statePtr->arcTarget += delta > 1 ? delta : 1;
+          if (statePtr->arcTarget > capacity)
+               statePtr->arcTarget = capacity;
+     }
+     else if (pagePtr->policyList == ARC_B2) {
+          int delta = lists[ARC_B1].size / lists[ARC_B2].size;
+          statePtr->arcTarget -= delta > 1 ? delta : 1;
+          if (statePtr->arcTarget < 0)
+               statePtr->arcTarget = 0;
+     }
+}
+
+// LIRS: the stack orders LIR pages and recently seen HIR pages by recency, the queue holds the
+// resident HIR pages that are evicted first. The stack bottom is always a LIR page
+int lirsTarget(victimState * statePtr) {
+     int hirFrames = statePtr->residentCount * LIRS_HIR_PERCENT / 100;
+     return statePtr->residentCount - (hirFrames > 1 ? hirFrames : 1);
+}
+
+// drops HIR pages off the bottom of the stack until a LIR page is there
+void lirsPruneStack(victimState * statePtr) {
+     pageList * stackPtr = &statePtr->policyLists[LIRS_STACK];
+     while (stackPtr->head && !stackPtr->head->lirsHot)
+          pageListRemove(statePtr, stackPtr->head);
+}
+
+void lirsMakeHot(victimState * statePtr, page * pagePtr) {
+     if (pagePtr->queued)
+          pageQueueRemove(statePtr, pagePtr);
+     pagePtr->lirsHot = 1;
+     ++statePtr->lirsCount;
+     pageListMoveToTail(statePtr, LIRS_STACK, pagePtr);
+     // the stack bottom turns into a resident HIR page when there are too many LIR pages, which under
+     // global replacement can be several after another process left memory
+     while (statePtr->lirsCount > lirsTarget(statePtr)) {
+          page * bottomPtr = statePtr->policyLists[LIRS_STACK].head;
+          bottomPtr->lirsHot = 0;
+          --statePtr->lirsCount;
+          pageListRemove(statePtr, bottomPtr);
+          pageQueueAppend(statePtr, bottomPtr);
+          lirsPruneStack(statePtr);
+     }
+}
+
+void lirsTrackPage(victimState * statePtr, page * pagePtr) {
+     if (pagePtr->policyList == LIRS_STACK || statePtr->lirsCount < lirsTarget(statePtr)) {
+          // a non-resident HIR page still on the stack has a short reuse distance
+          lirsMakeHot(statePtr, pagePtr);
+     }
+     else {
+          pageListAppend(statePtr, LIRS_STACK, pagePtr);
+          pageQueueAppend(statePtr, pagePtr);
+          lirsPruneStack(statePtr);
+     }
+}
+
+void lirsUntrackPage(victimState * statePtr, page * pagePtr) {
+     if (pagePtr->queued)
+          pageQueueRemove(statePtr, pagePtr);
+     if (pagePtr->lirsHot) {
+          // only taken when no HIR page is resident
+          pagePtr->lirsHot = 0;
+          --statePtr->lirsCount;
+          pageListRemove(statePtr, pagePtr);
+          lirsPruneStack(statePtr);
+     }
+     // a HIR page stays on the stack as a non-resident entry
+}
+
+void lirsTouchPage(victimState * statePtr, page * pagePtr) {
+     if (pagePtr->lirsHot) {
+          pageListMoveToTail(statePtr, LIRS_STACK, pagePtr);
+          lirsPruneStack(statePtr);
+     }
+     else if (pagePtr->policyList == LIRS_STACK) {
+          lirsMakeHot(statePtr, pagePtr);
+     }
+     else {
+          pageListAppend(statePtr, LIRS_STACK, pagePtr);
+          pageQueueRemove(statePtr, pagePtr);
+          pageQueueAppend(statePtr, pagePtr);
+          lirsPruneStack(statePtr);
+     }
+}
+
+// the domain whose pages compete for frames when the process faults
+victimState * victimDomain(process * procPtr, ram * ramPtr) {
+     return ramPtr->globalScope ? &ramPtr->globalVictims : &procPtr->victims;
+}
+
+// returns 1 if the policy's victims are found by scanning the per-frame metadata, so it keeps no victim structures
+static inline int scansForVictims(ram * ramPtr, policy desiredPolicy) {
+     return ramPtr->victimScan && (desiredPolicy == FIFO || desiredPolicy == LRU || desiredPolicy == LFU
+          || desiredPolicy == MFU);
+}
+
+// adds a page that was just brought into memory to the victim structures of the policy
+POLICY_CORE void policyTrackPageFor(process * procPtr, page * pagePtr, ram * ramPtr, policy compiled) {
+     policy desiredPolicy = RUNTIME_POLICY(compiled, ramPtr);
+     victimState * statePtr = victimDomain(procPtr, ramPtr);
+     ++statePtr->residentCount;
+     if (compiled == ANY_POLICY || compiled == ARC || compiled == LIRS)
+          pagePtr->freshlyPagedIn = 1;
+     if (scansForVictims(ramPtr, desiredPolicy))
+          return;
+     switch (desiredPolicy) {
+          case FIFO:
+          case LRU:
+               residentListInsert(statePtr, pagePtr, desiredPolicy);
+               break;
+          case LFU:
+          case MFU:
+          case OPT:
+               heapInsert(statePtr, pagePtr, desiredPolicy);
+               break;
+          case RANDOM:
+               residentTreeAdd(statePtr, statePtr->keyedByFrame ? pagePtr->physPageID : pagePtr->pageID, 1);
+               break;
+          case CLOCK:
+               clockTrackPage(statePtr, pagePtr);
+               break;
+          case ARC:
+               arcTrackPage(statePtr, pagePtr);
+               break;
+          case TWOQ:
+               twoQueueTrackPage(statePtr, pagePtr);
+               break;
+          case LIRS:
+               lirsTrackPage(statePtr, pagePtr);
+               break;
+     }
+}
+
+void policyTrackPage(process * procPtr, page * pagePtr, ram * ramPtr) {
+     policyTrackPageFor(procPtr, pagePtr, ramPtr, ANY_POLICY);
+}
+
+// removes a page that is leaving memory from the victim structures of the policy
+POLICY_CORE void policyUntrackPageFor(process * procPtr, page * pagePtr, ram * ramPtr, policy compiled) {
+     policy desiredPolicy = RUNTIME_POLICY(compiled, ramPtr);
+     victimState * statePtr = victimDomain(procPtr, ramPtr);
+     --statePtr->residentCount;
+     if (scansForVictims(ramPtr, desiredPolicy))
+          return;
+     switch (desiredPolicy) {
+          case FIFO:
+          case LRU:
+               pageListRemove(statePtr, pagePtr);
+               break;
+          case LFU:
+          case MFU:
+          case OPT:
+               heapRemove(statePtr, pagePtr, desiredPolicy);
+               break;
+          case RANDOM:
+               residentTreeAdd(statePtr, statePtr->keyedByFrame ? pagePtr->physPageID : pagePtr->pageID, -1);
+               break;
+          case CLOCK:
+               clockUntrackPage(statePtr, pagePtr);
+               break;
+          case ARC:
+               arcUntrackPage(statePtr, pagePtr);
+               break;
+          case TWOQ:
+               twoQueueUntrackPage(statePtr, pagePtr);
+               break;
+          case LIRS:
+               lirsUntrackPage(statePtr, pagePtr);
+               break;
+     }
+}
+
+// repositions a resident page after its reference metadata changed
+// the reference that faulted a page in counts as its first use, not as a repeat
+POLICY_CORE void policyTouchPageFor(process * procPtr, page * pagePtr, ram * ramPtr, policy compiled) {
+     victimState * statePtr = victimDomain(procPtr, ramPtr);
+     int fresh = 0;
+     if (compiled == ANY_POLICY || compiled == ARC || compiled == LIRS) {
+          fresh = pagePtr->freshlyPagedIn;
+          pagePtr->freshlyPagedIn = 0;
+     }
+     if (scansForVictims(ramPtr, RUNTIME_POLICY(compiled, ramPtr)))
+          return;
+     switch (RUNTIME_POLICY(compiled, ramPtr)) {
+          case LRU:
+               pageListRemove(statePtr, pagePtr);
+               residentListInsert(statePtr, pagePtr, LRU);
+               break;
+          case LFU:
+               heapSiftDown(statePtr, pagePtr->heapIndex, LFU);
+               break;
+          case MFU:
+               heapSiftUp(statePtr, pagePtr->heapIndex, MFU);
+               break;
+          case OPT:
+               // a page is paged in with the next use of its previous reference, so it can move either way
+               heapSiftUp(statePtr, pagePtr->heapIndex, OPT);
+               heapSiftDown(statePtr, pagePtr->heapIndex, OPT);
+               break;
+          case CLOCK:
+               pagePtr->referenceBit = 1;
+               break;
+          case ARC:
+               if (!fresh)
+                    pageListMoveToTail(statePtr, ARC_T2, pagePtr);
+               break;
+          case TWOQ:
+               if (pagePtr->policyList == TWOQ_AM)
+                    pageListMoveToTail(statePtr, TWOQ_AM, pagePtr);
+               break;
+          case LIRS:
+               if (!fresh)
+                    lirsTouchPage(statePtr, pagePtr);
+               break;
+          default:
+               break;
+     }
+}
+
+// lets a policy learn from a miss on the page before a victim is chosen for it
+POLICY_CORE void policyFaultPageFor(process * procPtr, page * pagePtr, ram * ramPtr, policy compiled) {
+     if (RUNTIME_POLICY(compiled, ramPtr) == ARC)
+          arcFaultPage(victimDomain(procPtr, ramPtr), pagePtr);
+}
+
+stackDistance * createStackDistance(int maxFrames) {
+     stackDistance * stackPtr = malloc(sizeof(stackDistance));
+     stackPtr->maxFrames = maxFrames;
+     stackPtr->capacity = STACK_MIN_SLOTS;
+     stackPtr->nextSlot = 0;
+     stackPtr->liveCount = 0;
+     stackPtr->tree = calloc(stackPtr->capacity + 1, sizeof(int));
+     stackPtr->slotOwner = calloc(stackPtr->capacity, sizeof(page *));
+     stackPtr->distanceCounts = calloc(maxFrames + 1, sizeof(long long));
+     stackPtr->deepReferences = 0;
+     stackPtr->coldReferences = 0;
+     return stackPtr;
+}
+
+void freeStackDistance(stackDistance * stackPtr) {
+     free(stackPtr->tree);
+     free(stackPtr->slotOwner);
+     free(stackPtr->distanceCounts);
+     free(stackPtr);
+}
+
+void stackTreeAdd(stackDistance * stackPtr, int slot, int delta) {
+     int i;
+     for (i = slot + 1; i <= stackPtr->capacity; i += i & -i)
+          stackPtr->tree[i] += delta;
+}
+
+// returns the number of live slots at or below the given slot
+int stackTreePrefix(stackDistance * stackPtr, int slot) {
+     int sum = 0;
+     int i;
+     for (i = slot + 1; i > 0; i -= i & -i)
+          sum += stackPtr->tree[i];
+     return sum;
+}
+
+// moves the live slots to the front of the window in order, growing the window if it is mostly live
+void compactStackDistance(stackDistance * stackPtr) {
+     if (stackPtr->liveCount * 2 > stackPtr->capacity) {
+          stackPtr->capacity *= 2;
+          stackPtr->slotOwner = realloc(stackPtr->slotOwner, sizeof(page *) * stackPtr->capacity);
+          stackPtr->tree = realloc(stackPtr->tree, sizeof(int) * (stackPtr->capacity + 1));
+     }
+
+     int kept = 0;
+     int i;
+     for (i = 0; i < stackPtr->nextSlot; ++i) {
+          if (stackPtr->slotOwner[i]) {
+               stackPtr->slotOwner[kept] = stackPtr->slotOwner[i];
+               stackPtr->slotOwner[kept]->stackSlot = kept;
+               ++kept;
+          }
+     }
+     memset(stackPtr->slotOwner + kept, 0, sizeof(page *) * (stackPtr->capacity - kept));
+     stackPtr->nextSlot = kept;
+
+     // linear time Fenwick build over the first kept slots
+     memset(stackPtr->tree, 0, sizeof(int) * (stackPtr->capacity + 1));
+     for (i = 1; i <= stackPtr->capacity; ++i) {
+          if (i <= kept)
+               stackPtr->tree[i] += 1;
+          int parent = i + (i & -i);
+          if (parent <= stackPtr->capacity)
+               stackPtr->tree[parent] += stackPtr->tree[i];
+     }
+}
+
+// takes the page's latest reference out of the stack
+void stackDistanceForget(stackDistance * stackPtr, page * pagePtr) {
+     if (pagePtr->stackSlot < 0)
+          return;
+     stackTreeAdd(stackPtr, pagePtr->stackSlot, -1);
+     stackPtr->slotOwner[pagePtr->stackSlot] = NULL;
+     pagePtr->stackSlot = -1;
+     --stackPtr->liveCount;
+}
+
+// records the stack distance of a reference and moves the page to the top of the stack
+void stackDistanceReference(stackDistance * stackPtr, page * pagePtr) {
+     if (pagePtr->stackSlot < 0) {
+          ++stackPtr->coldReferences;
+     }
+     else {
+          int distance = stackPtr->liveCount - stackTreePrefix(stackPtr, pagePtr->stackSlot) + 1;
+          if (distance <= stackPtr->maxFrames)
+               ++stackPtr->distanceCounts[distance];
+          else
+               ++stackPtr->deepReferences;
+          stackDistanceForget(stackPtr, pagePtr);
+     }
+
+     if (stackPtr->nextSlot == stackPtr->capacity)
+          compactStackDistance(stackPtr);
+     pagePtr->stackSlot = stackPtr->nextSlot++;
+     stackPtr->slotOwner[pagePtr->stackSlot] = pagePtr;
+     stackTreeAdd(stackPtr, pagePtr->stackSlot, 1);
+     ++stackPtr->liveCount;
+}
+
+traceRecorder * openTraceRecorder(char * path, int numberOfFrames) {
+     traceRecorder * recorderPtr = malloc(sizeof(traceRecorder));
+     recorderPtr->file = fopen(path, "wb");
+     if (!recorderPtr->file) {
+          printf("ERROR OPENING TRACE FILE %s\n", path);
+          exit(1);
+     }
+     memset(&recorderPtr->header, 0, sizeof(traceHeader));
+     memcpy(recorderPtr->header.magic, TRACE_MAGIC, sizeof(TRACE_MAGIC));
+     recorderPtr->header.version = TRACE_VERSION;
+     recorderPtr->header.recordSize = sizeof(traceRecord);
+     recorderPtr->header.numberOfFrames = numberOfFrames;
+     recorderPtr->bufferedRecords = 0;
+     // placeholder, the real header is written once the segment table is known
+     fwrite(&recorderPtr->header, sizeof(traceHeader), 1, recorderPtr->file);
+     return recorderPtr;
+}
+
+void flushTraceRecorder(traceRecorder * recorderPtr) {
+     if (fwrite(recorderPtr->buffer, sizeof(traceRecord), recorderPtr->bufferedRecords, recorderPtr->file) !=
+          (size_t)recorderPtr->bufferedRecords) {
+          printf("ERROR WRITING TRACE FILE\n");
+          exit(1);
+     }
+     recorderPtr->bufferedRecords = 0;
+}
+
+void recordTraceEvent(traceRecorder * recorderPtr, traceEvent event, int time, int pid, int value) {
+     if (event == TRACE_BEGIN) {
+          if (recorderPtr->header.numberOfSegments == TRACE_MAX_SEGMENTS) {
+               printf("ERROR TRACE HOLDS AT MOST %d WORKLOADS\n", TRACE_MAX_SEGMENTS);
+               exit(1);
+          }
+          recorderPtr->header.segmentStart[recorderPtr->header.numberOfSegments++] = recorderPtr->header.numberOfRecords;
+     }
+     traceRecord * recordPtr = &recorderPtr->buffer[recorderPtr->bufferedRecords++];
+     recordPtr->time = time;
+     recordPtr->pid = pid;
+     recordPtr->event = ((unsigned int)event << TRACE_EVENT_SHIFT) | ((unsigned int)value & TRACE_VALUE_MASK);
+     ++recorderPtr->header.numberOfRecords;
+     if (recorderPtr->bufferedRecords == TRACE_BUFFER_RECORDS)
+          flushTraceRecorder(recorderPtr);
+}
+
+void closeTraceRecorder(traceRecorder * recorderPtr) {
+     flushTraceRecorder(recorderPtr);
+     recorderPtr->header.segmentStart[recorderPtr->header.numberOfSegments] = recorderPtr->header.numberOfRecords;
+     fseek(recorderPtr->file, 0, SEEK_SET);
+     fwrite(&recorderPtr->header, sizeof(traceHeader), 1, recorderPtr->file);
+     fclose(recorderPtr->file);
+     free(recorderPtr);
+}
+
+// brings in a page from the disk to the memory to the first free page in memory
+// returns 0 if page was already in memory, 1 otherwise
+POLICY_CORE int pageInFor(process * procPtr, page * pagePtr, ram * ramPtr, int time, policy compiled) {
+     if (pagePtr->inMemory) {
+          return 0;
+     }
+
+     enterPhase(PHASE_PAGING);
+
+     memory * memPtr = firstFreePage(procPtr, ramPtr);
+     if(memPtr){
+          int firstFrame;
+          frameAllocator * allocPtr = frameSourceOf(procPtr, ramPtr, &firstFrame);
+          takeFrame(allocPtr, memPtr->memID - firstFrame);
+          memPtr->pagePtr = pagePtr;
+          memPtr->busy = 1;
+          pagePtr->inMemory = 1;
+          if (compiled == ANY_POLICY || compiled == FIFO)
+               pagePtr->timePagedIn = time;
+          pagePtr->physPageID = memPtr->memID; //set the physical page ID
+          ramPtr->meta.owner[memPtr->memID] = pagePtr->pid;
+          if (ramPtr->victimScan) {
+               ramPtr->meta.lastReferenced[memPtr->memID] = pagePtr->timeLastReferenced;
+               ramPtr->meta.pagedIn[memPtr->memID] = pagePtr->timePagedIn;
+               ramPtr->meta.referenceCount[memPtr->memID] = pagePtr->referenceCount;
+          }
+          policyTrackPageFor(procPtr, pagePtr, ramPtr, compiled);
+     }
+     leavePhase();
+     return 1;
+}
+
+int pageIn(process * procPtr, page * pagePtr, ram * ramPtr, int time) {
+     return pageInFor(procPtr, pagePtr, ramPtr, time, ANY_POLICY);
+}
+
+// removes a page from memory
+// returns 1 if page found and removed, 0 otherwise
+POLICY_CORE int pageOutFor(process * procPtr, page * pagePtr, ram * ramPtr, int time, policy compiled) {
+     memory * memPtr = findPageInMemory(pagePtr, ramPtr);
+     if(memPtr && memPtr->busy && memPtr->pagePtr == pagePtr) {
+          enterPhase(PHASE_PAGING);
+          // page found in memory
+          if (pagePtr->prefetched) {
+               ramPtr->prefetch.wasted += 1;
+               pagePtr->prefetched = 0;
+          }
+          policyUntrackPageFor(procPtr, pagePtr, ramPtr, compiled);
+          int firstFrame;
+          frameAllocator * allocPtr = frameSourceOf(procPtr, ramPtr, &firstFrame);
+          releaseFrame(allocPtr, memPtr->memID - firstFrame);
+          memPtr->busy = 0;
+          ramPtr->meta.owner[memPtr->memID] = -1;
+          memPtr->pagePtr->inMemory = 0;
+          if (compiled == ANY_POLICY || compiled == LRU)
+               memPtr->pagePtr->timeLastReferenced = 0;
+          if (compiled == ANY_POLICY || compiled == LFU || compiled == MFU)
+               memPtr->pagePtr->referenceCount = 0;
+          memPtr->pagePtr->physPageID = -1; //reset the physical page ID
+          leavePhase();
+          return 1;
+     }
+     return 0;
+}
+
+int pageOut(process * procPtr, page * pagePtr, ram * ramPtr, int time) {
+     return pageOutFor(procPtr, pagePtr, ramPtr, time, ANY_POLICY);
+}
+
+// OPT: the point a page's next use is counted from, for a reference with the given index made at the given time
+// a fault only evicts its own process' pages by default, and the index orders them exactly however long the process
+// is blocked on the disk or suspended. Under --global pages of different processes compete, so the distance is
+// counted from the tick instead, which assumes every process keeps making one reference a tick and is only
+// exact without -a and -D
+static inline int nextUseAfter(ram * ramPtr, int index, int time) {
+     return ramPtr->globalScope ? time : index;
+}
+
+// updates metadata for referencing a page
+POLICY_CORE void referencePageFor(process * procPtr, page * pagePtr, ram * ramPtr, int time, policy compiled) {
+     if (compiled == ANY_POLICY || compiled == LRU)
+          pagePtr->timeLastReferenced = time;
+     if (compiled == ANY_POLICY || compiled == LFU || compiled == MFU)
+          pagePtr->referenceCount += 1;
+     procPtr->pageLastReferenced = pagePtr;
+     if ((compiled == ANY_POLICY || compiled == OPT) && procPtr->nextUseDelta) {
+          int delta = procPtr->referencesMade < procPtr->numberOfReferences ?
+               procPtr->nextUseDelta[procPtr->referencesMade] : INT_MAX;
+          pagePtr->nextUse = (delta == INT_MAX) ? INT_MAX : nextUseAfter(ramPtr, procPtr->referencesMade, time) + delta;
+          ++procPtr->referencesMade;
+     }
+     if (pagePtr->inMemory) {
+          if (ramPtr->victimScan) {
+               if (compiled == ANY_POLICY || compiled == LRU)
+                    ramPtr->meta.lastReferenced[pagePtr->physPageID] = time;
+               if (compiled == ANY_POLICY || compiled == LFU || compiled == MFU)
+                    ramPtr->meta.referenceCount[pagePtr->physPageID] = pagePtr->referenceCount;
+          }
+          policyTouchPageFor(procPtr, pagePtr, ramPtr, compiled);
+     }
+     if (ramPtr->stackPtr)
+          stackDistanceReference(ramPtr->stackPtr, pagePtr);
+     if (activeLog)
+          --activeLog->referenceBudget;
+}
+
+void referencePage(process * procPtr, page * pagePtr, ram * ramPtr, int time) {
+     referencePageFor(procPtr, pagePtr, ramPtr, time, ANY_POLICY);
+}
+
+// returns pointer of the most recently referenced page
+page * previouslyReferencedPage(process * procPtr) {
+     return procPtr->pageLastReferenced;
+}
+
+// draws the page referenced after lastPageID from a process' reference stream
+int nextReferenceID(rng * streamPtr, int lastPageID, int numberOfPages, int localityPercent) {
+     int newReferencePageID = lastPageID;
+     int localityReferenceChance = rngBelow(streamPtr, 100);
+
+     if (localityReferenceChance < localityPercent) {
+          int localityDifference = rngBelow(streamPtr, 3);
+          switch (localityDifference) {
+               case 0:
+                    newReferencePageID = (lastPageID + 1) % numberOfPages;
+                    break;
+               case 1:
+                    newReferencePageID = (lastPageID - 1) % numberOfPages;
+                    if (newReferencePageID < 0)
+                         newReferencePageID += numberOfPages;
+                    break;
+               case 2:
+                    break;
+               default:
+                    printf("ERROR GENERATING REFERENCE\n");
+                    exit(1);
+          }
+     }
+
+     else {
+          int offsetBetweenPages = newReferencePageID - lastPageID;
+          while ((offsetBetweenPages < 2) && (offsetBetweenPages > -2)) {
+               newReferencePageID = rngBelow(streamPtr, numberOfPages);
+               offsetBetweenPages = newReferencePageID - lastPageID;
+          }
+     }
+
+     return newReferencePageID;
+}
+
+// generates a random page to reference
+page * generateReference(process * procPtr, int time) {
+     page * lastReferenced = previouslyReferencedPage(procPtr);
+     return &procPtr->pageTable[nextReferenceID(&procPtr->referenceStream, lastReferenced->pageID,
+          procPtr->numberOfPages, procPtr->localityPercent)];
+}
+
+// OPT: replays the process' whole reference string from a copy of its reference stream before it starts
+// and stores, for every reference, how many references of the process later the same page is referenced next
+void buildNextUseIndex(process * procPtr, arena * arenaPtr) {
+     int length = procPtr->serviceTime;
+     if (procPtr->nextUseCapacity < length) {
+          procPtr->nextUseDelta = arenaAlloc(arenaPtr, sizeof(int) * length);
+          procPtr->nextUseCapacity = length;
+     }
+     int * delta = procPtr->nextUseDelta;
+     int * lastSeen = malloc(sizeof(int) * procPtr->numberOfPages);
+     rng stream = procPtr->referenceStream;
+     int i;
+     // the string is written into delta first and turned into distances in place from the back
+     for (i = 0; i < length; ++i)
+          delta[i] = (i == 0) ? 0 : nextReferenceID(&stream, delta[i - 1], procPtr->numberOfPages,
+               procPtr->localityPercent);
+     for (i = 0; i < procPtr->numberOfPages; ++i)
+          lastSeen[i] = -1;
+     for (i = length - 1; i >= 0; --i) {
+          int pageID = delta[i];
+          delta[i] = (lastSeen[pageID] < 0) ? INT_MAX : lastSeen[pageID] - i;
+          lastSeen[pageID] = i;
+     }
+     free(lastSeen);
+     procPtr->numberOfReferences = length;
+}
+
+// the victim structures keep each process' candidates ordered exactly like a scan of its frames
+// would, including giving ties to the lowest frame, so every policy reads its victim off the top
+
+// the frame with the smallest FIFO, LRU or LFU key, or the largest MFU key, among those the process may
+// evict from, found by scanning the per-frame copy of the key over the process' shard, or over all memory
+page * scanForVictim(process * procPtr, ram * ramPtr, policy desiredPolicy) {
+     int * keys = ramPtr->meta.referenceCount;
+     if (desiredPolicy == FIFO)
+          keys = ramPtr->meta.pagedIn;
+     else if (desiredPolicy == LRU)
+          keys = ramPtr->meta.lastReferenced;
+     int firstFrame = procPtr->shardPtr ? procPtr->shardPtr->firstFrame : 0;
+     int frames = framesFor(procPtr, ramPtr);
+     int pid = ramPtr->globalScope ? -1 : procPtr->pid;
+     int memID = desiredPolicy == MFU ?
+          frameArgMax(keys + firstFrame, ramPtr->meta.owner + firstFrame, frames, pid) :
+          frameArgMin(keys + firstFrame, ramPtr->meta.owner + firstFrame, frames, pid);
+     return memID < 0 ? NULL : ramPtr->frames[firstFrame + memID].pagePtr;
+}
+
+page * pageReplaceLRU(process * procPtr, ram * ramPtr, int time, policy desiredPolicy) {
+     if (ramPtr->victimScan)
+          return scanForVictim(procPtr, ramPtr, LRU);
+     return victimDomain(procPtr, ramPtr)->policyLists[LIST_RESIDENT].head;
+}
+
+page * pageReplaceLFU(process * procPtr, ram * ramPtr, int time, policy desiredPolicy) {
+     if (ramPtr->victimScan)
+          return scanForVictim(procPtr, ramPtr, LFU);
+     victimState * statePtr = victimDomain(procPtr, ramPtr);
+     return statePtr->victimHeapSize ? statePtr->victimHeap[0] : NULL;
+}
+
+page * pageReplaceMFU(process * procPtr, ram * ramPtr, int time, policy desiredPolicy) {
+     if (ramPtr->victimScan)
+          return scanForVictim(procPtr, ramPtr, MFU);
+     victimState * statePtr = victimDomain(procPtr, ramPtr);
+     return statePtr->victimHeapSize ? statePtr->victimHeap[0] : NULL;
+}
+
+// the resident page whose next reference lies farthest in the future
+page * pageReplaceOPT(process * procPtr, ram * ramPtr, int time, policy desiredPolicy) {
+     victimState * statePtr = victimDomain(procPtr, ramPtr);
+     return statePtr->victimHeapSize ? statePtr->victimHeap[0] : NULL;
+}
+
+page * pageReplaceFIFO(process * procPtr, ram * ramPtr, int time, policy desiredPolicy) {
+     if (ramPtr->victimScan)
+          return scanForVictim(procPtr, ramPtr, FIFO);
+     return victimDomain(procPtr, ramPtr)->policyLists[LIST_RESIDENT].head;
+}
+
+// picks a uniformly random resident page of the domain, numbered in key order
+page * pageReplaceRANDOM(process * procPtr, ram * ramPtr, int time, policy desiredPolicy) {
+     victimState * statePtr = victimDomain(procPtr, ramPtr);
+     if (statePtr->residentCount == 0)
+          return NULL;
+     int randomCount = rngBelow(&procPtr->victimStream, statePtr->residentCount) + 1;
+     int key = residentTreeFind(statePtr, randomCount);
+     return statePtr->keyedByFrame ? ramPtr->frames[key].pagePtr : &procPtr->pageTable[key];
+}
+
+// sweeps the hand, clearing reference bits, to the first page not referenced since the last sweep
+page * pageReplaceCLOCK(process * procPtr, ram * ramPtr, int time, policy desiredPolicy) {
+     victimState * statePtr = victimDomain(procPtr, ramPtr);
+     pageList * ringPtr = &statePtr->policyLists[LIST_RESIDENT];
+     if (!ringPtr->head)
+          return NULL;
+     page * handPtr = statePtr->clockHand ? statePtr->clockHand : ringPtr->head;
+     while (handPtr->referenceBit) {
+          handPtr->referenceBit = 0;
+          handPtr = handPtr->nextResident ? handPtr->nextResident : ringPtr->head;
+     }
+     statePtr->clockHand = handPtr;
+     return handPtr;
+}
+
+// evicts from T1 while it is over its target, a tie goes to T1 when the faulting page is a B2 ghost
+page * pageReplaceARC(process * procPtr, ram * ramPtr, int time, policy desiredPolicy, page * desiredPage) {
+     victimState * statePtr = victimDomain(procPtr, ramPtr);
+     pageList * lists = statePtr->policyLists;
+     int t1Size = lists[ARC_T1].size;
+     if (t1Size > 0 && (t1Size > statePtr->arcTarget || lists[ARC_T2].size == 0 ||
+          (desiredPage->policyList == ARC_B2 && t1Size == statePtr->arcTarget)))
+          return lists[ARC_T1].head;
+     return lists[ARC_T2].head;
+}
+
+// first-time pages leave from A1in while it is over its share, otherwise the least recent hot page
+page * pageReplaceTWOQ(process * procPtr, ram * ramPtr, int time, policy desiredPolicy) {
+     victimState * statePtr = victimDomain(procPtr, ramPtr);
+     pageList * lists = statePtr->policyLists;
+     int inLimit = statePtr->residentCount * TWOQ_IN_PERCENT / 100;
+     if (lists[TWOQ_A1IN].size > 0 && (lists[TWOQ_A1IN].size > (inLimit > 1 ? inLimit : 1) || lists[TWOQ_AM].size == 0))
+          return lists[TWOQ_A1IN].head;
+     return lists[TWOQ_AM].head;
+}
+
+// the oldest resident HIR page, or the stack bottom if every resident page is LIR
+page * pageReplaceLIRS(process * procPtr, ram * ramPtr, int time, policy desiredPolicy) {
+     victimState * statePtr = victimDomain(procPtr, ramPtr);
+     if (statePtr->policyLists[LIRS_QUEUE].head)
+          return statePtr->policyLists[LIRS_QUEUE].head;
+     return statePtr->policyLists[LIRS_STACK].head;
+}
+
+POLICY_CORE page * pageReplace(process * procPtr, ram * ramPtr, int time, policy desiredPolicy, page * desiredPage) {
+     page * pageToReplace = NULL;
+     switch (desiredPolicy) {
+          case LRU:
+               pageToReplace = pageReplaceLRU(procPtr, ramPtr, time, desiredPolicy);
+               break;
+          case LFU:
+               pageToReplace = pageReplaceLFU(procPtr, ramPtr, time, desiredPolicy);
+               break;
+          case MFU:
+               pageToReplace = pageReplaceMFU(procPtr, ramPtr, time, desiredPolicy);
+               break;
+          case FIFO:
+               pageToReplace = pageReplaceFIFO(procPtr, ramPtr, time, desiredPolicy);
+               break;
+          case RANDOM:
+               pageToReplace = pageReplaceRANDOM(procPtr, ramPtr, time, desiredPolicy);
+               break;
+          case CLOCK:
+               pageToReplace = pageReplaceCLOCK(procPtr, ramPtr, time, desiredPolicy);
+               break;
+          case ARC:
+               pageToReplace = pageReplaceARC(procPtr, ramPtr, time, desiredPolicy, desiredPage);
+               break;
+          case TWOQ:
+               pageToReplace = pageReplaceTWOQ(procPtr, ramPtr, time, desiredPolicy);
+               break;
+          case LIRS:
+               pageToReplace = pageReplaceLIRS(procPtr, ramPtr, time, desiredPolicy);
+               break;
+          case OPT:
+               pageToReplace = pageReplaceOPT(procPtr, ramPtr, time, desiredPolicy);
+               break;
+          default:
+               printf("ERROR INVALID POLICY\n");
+               exit(1);
+     }
+     return(pageToReplace);
+}
+
+// checks if the process has started running by the specified time
+int processStarted(process * procPtr, int time) {
+     return ((procPtr->firstRunTime != -1) && (procPtr->firstRunTime <= time));
+}
+
+// checks if the process is complete, time spent suspended does not count towards its service time
+int processCompleted(process * procPtr, int time) {
+     return (time >= (procPtr->firstRunTime + procPtr->serviceTime + procPtr->suspendedTicks));
+}
+
+void initEventLog(eventLog * logPtr, config * cfg, FILE * sink) {
+     logPtr->sink = sink;
+     logPtr->buffer = malloc(LOG_BUFFER_BYTES);
+     logPtr->used = 0;
+     logPtr->verbosity = cfg->logVerbosity;
+     logPtr->sampleInterval = cfg->logSampleInterval;
+     logPtr->sampleCountdown = 0;
+     logPtr->referenceBudget = cfg->logLimit;
+}
+
+void flushEventLog(eventLog * logPtr) {
+     if (logPtr->used && fwrite(logPtr->buffer, 1, logPtr->used, logPtr->sink) != logPtr->used) {
+          printf("ERROR WRITING EVENT LOG\n");
+          exit(1);
+     }
+     logPtr->used = 0;
+}
+
+void closeEventLog(eventLog * logPtr) {
+     flushEventLog(logPtr);
+     free(logPtr->buffer);
+}
+
+// returns 1 if the running trial logs events of the given verbosity right now
+int logging(int verbosity) {
+     return activeLog && activeLog->verbosity >= verbosity && activeLog->referenceBudget > 0;
+}
+
+// appends one record and its payload to the thread's log buffer
+void logEventRecord(logEvent event, int time, int pid, int * payload, int payloadWords) {
+     logRecord record = {event, time, pid, payloadWords};
+     size_t payloadBytes = sizeof(int) * payloadWords;
+     if (activeLog->used + sizeof(logRecord) + payloadBytes > LOG_BUFFER_BYTES)
+          flushEventLog(activeLog);
+     if (sizeof(logRecord) + payloadBytes > LOG_BUFFER_BYTES) {
+          // too big to batch, e.g. the map of a huge memory
+          fwrite(&record, sizeof(logRecord), 1, activeLog->sink);
+          fwrite(payload, sizeof(int), payloadWords, activeLog->sink);
+          return;
+     }
+     memcpy(activeLog->buffer + activeLog->used, &record, sizeof(logRecord));
+     memcpy(activeLog->buffer + activeLog->used + sizeof(logRecord), payload, payloadBytes);
+     activeLog->used += sizeof(logRecord) + payloadBytes;
+}
+
+// logs a hit or miss of a reference, keeping only one in sampleInterval
+void logReference(logEvent event, int time, int pid, int pageID, int frame, int pageOutID) {
+     if (activeLog->sampleCountdown > 0) {
+          --activeLog->sampleCountdown;
+          return;
+     }
+     activeLog->sampleCountdown = activeLog->sampleInterval - 1;
+     int payload[3] = {pageID, frame, pageOutID};
+     logEventRecord(event, time, pid, payload, event == LOG_MISS_REPLACE ? 3 : 2);
+}
+
+// logs a process entering or leaving memory followed by the memory map
+void logSwap(logEvent event, process * procPtr, ram * ramPtr, int time) {
+     int payload[2] = {procPtr->numberOfPages, procPtr->serviceTime};
+     logEventRecord(event, time, procPtr->pid, payload, 2);
+
+     logEventRecord(LOG_MAP, time, procPtr->pid, ramPtr->meta.owner, ramPtr->numberOfFrames);
+}
+
+// adds page faults to the fault rate of their slice of the run and of their second
+void countFault(thrashingStats * statsPtr, int trialTicks, int time, int faults) {
+     int slice = (int)((long long)time * THRASHING_WINDOWS / trialTicks);
+     statsPtr->faultsPerWindow[slice < THRASHING_WINDOWS ? slice : THRASHING_WINDOWS - 1] += faults;
+     if (time / TICKS_PER_SECOND != statsPtr->currentSecond) {
+          statsPtr->currentSecond = time / TICKS_PER_SECOND;
+          statsPtr->faultsThisSecond = 0;
+     }
+     statsPtr->faultsThisSecond += faults;
+     if (statsPtr->faultsThisSecond > statsPtr->peakFaultsPerSecond)
+          statsPtr->peakFaultsPerSecond = statsPtr->faultsThisSecond;
+}
+
+// forgets the process' working-set window and takes it out of the memory's totals
+// the working set size is kept as the room the process needs when it is resumed
+void clearWindow(process * procPtr, ram * ramPtr) {
+     if (!procPtr->window)
+          return;
+     int i;
+     for (i = 0; i < ramPtr->windowTicks; ++i) {
+          if (procPtr->window[i] >= 0) {
+               procPtr->windowUses[procPtr->window[i] >> 1] = 0;
+               procPtr->window[i] = -1;
+               --ramPtr->windowReferences;
+          }
+     }
+     ramPtr->workingSetTotal -= procPtr->workingSetSize;
+     ramPtr->windowFaults -= procPtr->windowFaults;
+     procPtr->windowFaults = 0;
+}
+
+// slides the process' working-set window forward to a reference made at the given time
+// the window spans the process' own latest references, so a process blocked on the disk or suspended
+// keeps its working set, and the slot of this reference holds the one that just fell out of the window
+void noteWindowReference(process * procPtr, ram * ramPtr, page * pagePtr, int time) {
+     int faulted = !pagePtr->inMemory;
+     // a shard's faults are counted once all shards have run the tick
+     if (faulted && procPtr->shardPtr)
+          procPtr->shardPtr->tickFaults += 1;
+     else if (faulted)
+          countFault(&ramPtr->thrashing, ramPtr->trialTicks, time, 1);
+     if (ramPtr->loadControl == LOAD_NONE)
+          return;
+     if (!procPtr->window) {
+          procPtr->window = arenaAlloc(ramPtr->arenaPtr, sizeof(int) * ramPtr->windowTicks);
+          procPtr->windowUses = arenaAlloc(ramPtr->arenaPtr, sizeof(int) * procPtr->numberOfPages);
+          memset(procPtr->window, -1, sizeof(int) * ramPtr->windowTicks);
+          memset(procPtr->windowUses, 0, sizeof(int) * procPtr->numberOfPages);
+     }
+
+     int * slotPtr = &procPtr->window[(procPtr->hitCount + procPtr->missCount) % ramPtr->windowTicks];
+     if (*slotPtr >= 0) {
+          if (--procPtr->windowUses[*slotPtr >> 1] == 0) {
+               --procPtr->workingSetSize;
+               --ramPtr->workingSetTotal;
+          }
+          if (*slotPtr & 1) {
+               --procPtr->windowFaults;
+               --ramPtr->windowFaults;
+          }
+          --ramPtr->windowReferences;
+     }
+     *slotPtr = pagePtr->pageID * 2 + faulted;
+     if (procPtr->windowUses[pagePtr->pageID]++ == 0) {
+          ++procPtr->workingSetSize;
+          ++ramPtr->workingSetTotal;
+     }
+     if (faulted) {
+          ++procPtr->windowFaults;
+          ++ramPtr->windowFaults;
+     }
+     ++ramPtr->windowReferences;
+}
+
+// opens the metrics file and writes its header
+metricsSink * openMetricsSink(config * cfg) {
+     metricsSink * sinkPtr = malloc(sizeof(metricsSink));
+     sinkPtr->file = fopen(cfg->metricsPath, cfg->metricsBinary ? "wb" : "w");
+     if (!sinkPtr->file) {
+          printf("ERROR OPENING METRICS FILE %s\n", cfg->metricsPath);
+          exit(1);
+     }
+     sinkPtr->binary = cfg->metricsBinary;
+     sinkPtr->failed = 0;
+     pthread_mutex_init(&sinkPtr->lock, NULL);
+     if (sinkPtr->binary) {
+          metricsHeader header;
+          memset(&header, 0, sizeof(header));
+          memcpy(header.magic, METRICS_MAGIC, sizeof(METRICS_MAGIC));
+          header.version = METRICS_VERSION;
+          header.recordSize = sizeof(metricRecord);
+          sinkPtr->failed = fwrite(&header, sizeof(header), 1, sinkPtr->file) != 1;
+     }
+     else {
+          fprintf(sinkPtr->file, "kind,trial,time,pid,faults,free_frames,active_jobs,queued_jobs,size,wait_ticks,hits,misses");
+          int bucket;
+          for (bucket = 0; bucket < METRICS_LATENCY_BUCKETS; ++bucket)
+               fprintf(sinkPtr->file, ",latency_%d", bucket);
+          fprintf(sinkPtr->file, "\n");
+     }
+     return sinkPtr;
+}
+
+void closeMetricsSink(metricsSink * sinkPtr, char * path) {
+     if (fclose(sinkPtr->file) != 0 || sinkPtr->failed) {
+          printf("ERROR WRITING METRICS FILE %s\n", path);
+          exit(1);
+     }
+     pthread_mutex_destroy(&sinkPtr->lock);
+     free(sinkPtr);
+}
+
+// writes the thread's buffered records to the metrics file in one go
+void flushMetrics(metricsRecorder * recorderPtr) {
+     metricsSink * sinkPtr = recorderPtr->sinkPtr;
+     pthread_mutex_lock(&sinkPtr->lock);
+     if (sinkPtr->binary) {
+          if (fwrite(recorderPtr->buffer, sizeof(metricRecord), recorderPtr->bufferedRecords, sinkPtr->file)
+               != (size_t)recorderPtr->bufferedRecords)
+               sinkPtr->failed = 1;
+     }
+     else {
+          int i;
+          for (i = 0; i < recorderPtr->bufferedRecords; ++i) {
+               metricRecord * recordPtr = &recorderPtr->buffer[i];
+               if (recordPtr->kind == METRIC_TICK) {
+                    fprintf(sinkPtr->file, "tick,%d,%d,,%d,%d,%d,%d,,,,", recordPtr->trial, recordPtr->time,
+                         recordPtr->tick.faults, recordPtr->tick.freeFrames, recordPtr->tick.activeJobs,
+                         recordPtr->tick.queuedJobs);
+                    int bucket;
+                    for (bucket = 0; bucket < METRICS_LATENCY_BUCKETS; ++bucket)
+                         fprintf(sinkPtr->file, ",");
+               }
+               else {
+                    fprintf(sinkPtr->file, "process,%d,%d,%d,,,,,%d,%d,%lld,%lld", recordPtr->trial, recordPtr->time,
+                         recordPtr->pid, recordPtr->process.size, recordPtr->process.waitTicks,
+                         recordPtr->process.hits, recordPtr->process.misses);
+                    int bucket;
+                    for (bucket = 0; bucket < METRICS_LATENCY_BUCKETS; ++bucket)
+                         fprintf(sinkPtr->file, ",%d", recordPtr->process.faultLatency[bucket]);
+               }
+               fprintf(sinkPtr->file, "\n");
+          }
+     }
+     pthread_mutex_unlock(&sinkPtr->lock);
+     recorderPtr->bufferedRecords = 0;
+}
+
+// returns the next free record of the thread's buffer, streaming the buffer out first if it is full
+metricRecord * nextMetricRecord(metricKind kind, int time, int pid) {
+     if (activeMetrics->bufferedRecords == METRICS_BUFFER_RECORDS)
+          flushMetrics(activeMetrics);
+     metricRecord * recordPtr = &activeMetrics->buffer[activeMetrics->bufferedRecords++];
+     recordPtr->kind = kind;
+     recordPtr->trial = activeMetrics->trial;
+     recordPtr->time = time;
+     recordPtr->pid = pid;
+     return recordPtr;
+}
+
+// counts the jobs that have arrived by the given time but are still waiting to be admitted
+// jobs are numbered in arrival order, so the count is the gap between the numbers of the next job
+// to arrive and the next job to be admitted
+void noteQueuedJobs(jobSource * sourcePtr, int time) {
+     jobSource * arrivalsPtr = &activeMetrics->arrivals;
+     if (!activeMetrics->arrivalsStarted) {
+          *arrivalsPtr = *sourcePtr;
+          activeMetrics->arrivalsStarted = 1;
+     }
+     while (arrivalsPtr->jobsLeft > 0 && arrivalsPtr->next.arrivalTime < time)
+          drawNextJob(arrivalsPtr);
+     int arrived = arrivalsPtr->jobsLeft > 0 ? arrivalsPtr->next.pid : sourcePtr->cfg->numberOfJobs;
+     int admitted = sourcePtr->jobsLeft > 0 ? sourcePtr->next.pid : sourcePtr->cfg->numberOfJobs;
+     activeMetrics->queuedJobs = arrived - admitted;
+}
+
+// records the state of memory and the scheduler at the end of a tick
+void sampleTick(scheduler * schedPtr, ram * ramPtr, int time) {
+     long long faults = 0;
+     int slice;
+     for (slice = 0; slice < THRASHING_WINDOWS; ++slice)
+          faults += ramPtr->thrashing.faultsPerWindow[slice];
+     metricRecord * recordPtr = nextMetricRecord(METRIC_TICK, time, -1);
+     recordPtr->tick.faults = (int)(faults - activeMetrics->faultsCounted);
+     recordPtr->tick.freeFrames = numberOfFreePages(ramPtr);
+     recordPtr->tick.activeJobs = schedPtr->runQueueSize;
+     recordPtr->tick.queuedJobs = activeMetrics->queuedJobs;
+     activeMetrics->faultsCounted = faults;
+}
+
+// counts a fault that kept the process blocked for the given number of ticks
+void noteFaultLatency(process * procPtr, int ticks) {
+#if METRICS_ENABLED
+     if (ticks <= 0)
+          return;
+     int bucket = 32 - __builtin_clz(ticks);
+     procPtr->faultLatency[bucket < METRICS_LATENCY_BUCKETS ? bucket : METRICS_LATENCY_BUCKETS - 1] += 1;
+#endif
+}
+
+// records the outcome of a process that has finished
+void recordProcessMetrics(process * procPtr, int time) {
+#if METRICS_ENABLED
+     metricRecord * recordPtr = nextMetricRecord(METRIC_PROCESS, time, procPtr->pid);
+     recordPtr->process.size = procPtr->numberOfPages;
+     // a job is admitted at the earliest in the tick after the one it arrives in
+     recordPtr->process.waitTicks = procPtr->firstRunTime - ((int)procPtr->arrivalTime + 1);
+     recordPtr->process.hits = procPtr->hitCount;
+     recordPtr->process.misses = procPtr->missCount;
+     memcpy(recordPtr->process.faultLatency, procPtr->faultLatency, sizeof(procPtr->faultLatency));
+     // faults that did not wait on the disk are the ones left over
+     long long waited = 0;
+     int bucket;
+     for (bucket = 1; bucket < METRICS_LATENCY_BUCKETS; ++bucket)
+          waited += procPtr->faultLatency[bucket];
+     recordPtr->process.faultLatency[0] = (int)(procPtr->missCount - waited);
+#endif
+}
+
+// returns the disk slot that finishes its read first
+int earliestDiskSlot(ram * ramPtr) {
+     int slot = 0;
+     int i;
+     for (i = 1; i < ramPtr->queueDepth; ++i) {
+          if (ramPtr->diskBusyUntil[i] < ramPtr->diskBusyUntil[slot])
+               slot = i;
+     }
+     return slot;
+}
+
+// queues a read behind the slot that frees up first and returns the time it completes
+int issueDiskRead(ram * ramPtr, int time) {
+     int slot = earliestDiskSlot(ramPtr);
+     int start = ramPtr->diskBusyUntil[slot] > time ? ramPtr->diskBusyUntil[slot] : time;
+     ramPtr->diskBusyUntil[slot] = start + ramPtr->diskLatency;
+     return ramPtr->diskBusyUntil[slot];
+}
+
+// a faulting process makes no further reference until its read comes back from the disk
+// without disk latency every read is done within the tick, and the disk is left untouched
+// so that shards can fault at the same time
+void demandRead(process * procPtr, ram * ramPtr, int time) {
+     if (ramPtr->diskLatency == 0) {
+          procPtr->blockedUntil = time;
+          return;
+     }
+     procPtr->blockedUntil = issueDiskRead(ramPtr, time);
+     ramPtr->prefetch.stallTicks += procPtr->blockedUntil - time;
+     if (metricsOn())
+          noteFaultLatency(procPtr, procPtr->blockedUntil - time);
+}
+
+// returns the step between two references, a wrap around the end of the process counting as one page
+int referenceStep(process * procPtr, page * fromPtr, page * toPtr) {
+     int step = toPtr->pageID - fromPtr->pageID;
+     if (step == procPtr->numberOfPages - 1)
+          return -1;
+     if (step == 1 - procPtr->numberOfPages)
+          return 1;
+     return step;
+}
+
+// sequential prefetcher: once two references in a row step by the same single page, the next
+// prefetchDepth pages in that direction are read ahead while the disk has a free slot
+// prefetched pages count as just used, so recency based policies do not evict them at once
+void prefetchPages(process * procPtr, page * currentPage, int step, ram * ramPtr, int time) {
+     int k;
+     for (k = 1; k <= ramPtr->prefetchDepth; ++k) {
+          int pageID = (currentPage->pageID + k * step + k * procPtr->numberOfPages) % procPtr->numberOfPages;
+          page * pagePtr = &procPtr->pageTable[pageID];
+          if (pagePtr == currentPage)
+               break;
+          if (pagePtr->inMemory)
+               continue;
+          // reads ahead never queue behind other reads
+          if (ramPtr->diskBusyUntil[earliestDiskSlot(ramPtr)] > time)
+               break;
+          if (numberOfFreePages(ramPtr) <= 0) {
+               page * pageToRemove = pageReplace(procPtr, ramPtr, time, ramPtr->desiredPolicy, pagePtr);
+               if (!pageToRemove || pageToRemove == currentPage)
+                    break;
+               pageOut(procPtr, pageToRemove, ramPtr, time);
+          }
+          pagePtr->timeLastReferenced = time;
+          pageIn(procPtr, pagePtr, ramPtr, time);
+          pagePtr->prefetched = 1;
+          pagePtr->readyAt = issueDiskRead(ramPtr, time);
+          ramPtr->prefetch.issued += 1;
+     }
+}
+
+// credits a reference to a page that is in memory thanks to the prefetcher, a read that
+// is still under way blocks the process like a fault, but only for the rest of the read
+void usePrefetchedPage(process * procPtr, page * pagePtr, ram * ramPtr, int time) {
+     pagePtr->prefetched = 0;
+     ramPtr->prefetch.used += 1;
+     if (pagePtr->readyAt <= time) {
+          ramPtr->prefetch.savedFaults += 1;
+     }
+     else {
+          ramPtr->prefetch.lateHits += 1;
+          ramPtr->prefetch.stallTicks += pagePtr->readyAt - time;
+          procPtr->blockedUntil = pagePtr->readyAt;
+     }
+}
+
+// services a reference to the desired page as a hit or a miss
+POLICY_CORE void accessPageFor(process * procPtr, page * desiredPage, ram * ramPtr, int time, policy compiled) {
+     // a shard keeps its own counts while its thread runs, they are added up after the run
+     long long * hitsPtr = procPtr->shardPtr ? &procPtr->shardPtr->hits : &ramPtr->hits;
+     long long * missesPtr = procPtr->shardPtr ? &procPtr->shardPtr->misses : &ramPtr->misses;
+     noteWindowReference(procPtr, ramPtr, desiredPage, time);
+     int step = referenceStep(procPtr, procPtr->pageLastReferenced, desiredPage);
+     int sequential = (step == 1 || step == -1) && step == procPtr->lastStep;
+     procPtr->lastStep = step;
+     //if desired page is not in memory
+     if (desiredPage->inMemory == 0) {
+          policyFaultPageFor(procPtr, desiredPage, ramPtr, compiled);
+          demandRead(procPtr, ramPtr, time);
+          if (freePagesFor(procPtr, ramPtr) <= 0) {
+               // MISS needs replacement
+               procPtr->missCount += 1;
+               *missesPtr += 1;
+               enterPhase(PHASE_REPLACE);
+               page * pageToRemove = pageReplace(procPtr, ramPtr, time, RUNTIME_POLICY(compiled, ramPtr), desiredPage);
+               leavePhase();
+               if (!pageToRemove) {
+                    // a replayed process can start while memory is full and own no frame to give up,
+                    // the page is then read from disk for this reference without being kept
+                    referencePageFor(procPtr, desiredPage, ramPtr, time, compiled);
+                    return;
+               }
+               pageOutFor(procPtr, pageToRemove, ramPtr, time, compiled);
+               pageInFor(procPtr, desiredPage, ramPtr, time, compiled);
+               if (logging(LOG_REFERENCES))
+                    logReference(LOG_MISS_REPLACE, time, procPtr->pid, desiredPage->pageID,
+                         desiredPage->physPageID, pageToRemove->pageID);
+          }
+          else {
+               // MISS with free pages
+               procPtr->missCount += 1;
+               *missesPtr += 1;
+               pageInFor(procPtr, desiredPage, ramPtr, time, compiled);
+               if (logging(LOG_REFERENCES))
+                    logReference(LOG_MISS, time, procPtr->pid, desiredPage->pageID, desiredPage->physPageID, 0);
+          }
+     }
+     else {
+          // HIT
+          procPtr->hitCount += 1;
+          *hitsPtr += 1;
+          if (desiredPage->prefetched)
+               usePrefetchedPage(procPtr, desiredPage, ramPtr, time);
+          if (logging(LOG_REFERENCES))
+               logReference(LOG_HIT, time, procPtr->pid, desiredPage->pageID, desiredPage->physPageID, 0);
+     }
+     //actually reference the page
+     referencePageFor(procPtr, desiredPage, ramPtr, time, compiled);
+     if (sequential && ramPtr->prefetchDepth > 0)
+          prefetchPages(procPtr, desiredPage, step, ramPtr, time);
+}
+
+void accessPage(process * procPtr, page * desiredPage, ram * ramPtr, int time) {
+     accessPageFor(procPtr, desiredPage, ramPtr, time, ANY_POLICY);
+}
+
+// generates the next reference of a running process and services it in every lane
+// the reference is drawn once from the first lane and replayed by page ID in the others
+POLICY_CORE void serviceReferenceFor(process * procPtr, ram * ramPtr, int time, policy compiled) {
+     //generate desired page
+     enterPhase(PHASE_GENERATE);
+     int desiredPageID = generateReference(procPtr, time)->pageID;
+     leavePhase();
+     if (ramPtr->recorderPtr)
+          recordTraceEvent(ramPtr->recorderPtr, TRACE_REFERENCE, time, procPtr->pid, desiredPageID);
+     for (; procPtr; procPtr = procPtr->nextLane, ramPtr = ramPtr->nextLane)
+          accessPageFor(procPtr, &procPtr->pageTable[desiredPageID], ramPtr, time, compiled);
+}
+
+// initiates process by referencing their page 0 
+void startProcess(process * procPtr, ram * ramPtr, int time) {
+     if (logging(LOG_SWAPS))
+          logSwap(LOG_ENTER, procPtr, ramPtr, time);
+     if (ramPtr->recorderPtr)
+          recordTraceEvent(ramPtr->recorderPtr, TRACE_ARRIVE, time, procPtr->pid, procPtr->numberOfPages);
+     procPtr->firstRunTime = time;
+     int frames = framesFor(procPtr, ramPtr);
+     procPtr->victims.arcCapacity = procPtr->numberOfPages < frames ? procPtr->numberOfPages : frames;
+     // replayed processes are handed their index, read off the trace, before they start
+     if (ramPtr->desiredPolicy == OPT && procPtr->sizeIndex >= 0)
+          buildNextUseIndex(procPtr, ramPtr->arenaPtr);
+     noteWindowReference(procPtr, ramPtr, &procPtr->pageTable[0], time);
+     demandRead(procPtr, ramPtr, time);
+     pageIn(procPtr, &procPtr->pageTable[0], ramPtr, time);
+     referencePage(procPtr, &procPtr->pageTable[0], ramPtr, time);
+     procPtr->missCount += 1;
+     ramPtr->jobsRun += 1;
+     ramPtr->misses += 1;
+     if (logging(LOG_REFERENCES))
+          logReference(LOG_MISS, time, procPtr->pid, procPtr->pageTable[0].pageID, procPtr->pageTable[0].physPageID, 0);
+}
+
+// pages out every page of the process and drops the history the policy keeps about them,
+// so that under global replacement no other process can pick them as victims or ghosts
+// returns the number of pages removed
+int swapOutProcess(process * procPtr, ram * ramPtr, int time) {
+     int count = 0;
+     int i;
+     for (i = 0; i < procPtr->numberOfPages; ++i) {
+          page * pagePtr = &procPtr->pageTable[i];
+          count += pageOut(procPtr, pagePtr, ramPtr, time);
+          if (pagePtr->queued)
+               pageQueueRemove(victimDomain(procPtr, ramPtr), pagePtr);
+          if (pagePtr->policyList != LIST_NONE)
+               pageListRemove(victimDomain(procPtr, ramPtr), pagePtr);
+          pagePtr->lirsHot = 0;
+     }
+     clearVictimState(&procPtr->victims);
+     clearWindow(procPtr, ramPtr);
+     return count;
+}
+
+// stops process and removes its pages from memory, returns the number of pages removed
+int stopProcess(process * procPtr, ram * ramPtr, int time) { 
+     if (ramPtr->recorderPtr)
+          recordTraceEvent(ramPtr->recorderPtr, TRACE_EXIT, time, procPtr->pid, 0);
+     int count = swapOutProcess(procPtr, ramPtr, time);
+     // pages of a finished process are never referenced again, so they stop taking up stack depth
+     if (ramPtr->stackPtr) {
+          int i;
+          for (i = 0; i < procPtr->numberOfPages; ++i)
+               stackDistanceForget(ramPtr->stackPtr, &procPtr->pageTable[i]);
+     }
+     
+     if (logging(LOG_SWAPS))
+          logSwap(LOG_EXIT, procPtr, ramPtr, time);
+     if (metricsOn())
+          recordProcessMetrics(procPtr, time);
+
+     return count;
+}
+
+void initScheduler(scheduler * schedPtr, jobSource * sourcePtr) {
+     schedPtr->sourcePtr = sourcePtr;
+     schedPtr->completionHeapSize = 0;
+     schedPtr->runQueueSize = 0;
+     schedPtr->suspendedCount = 0;
+     schedPtr->capacity = 64;
+     schedPtr->completionHeap = malloc(sizeof(process *) * schedPtr->capacity);
+     schedPtr->runQueue = malloc(sizeof(process *) * schedPtr->capacity);
+     schedPtr->suspended = malloc(sizeof(process *) * schedPtr->capacity);
+}
+
+void freeScheduler(scheduler * schedPtr) {
+     free(schedPtr->completionHeap);
+     free(schedPtr->runQueue);
+     free(schedPtr->suspended);
+}
+
+int completionTime(process * procPtr) {
+     return procPtr->firstRunTime + procPtr->serviceTime + procPtr->suspendedTicks;
+}
+
+// returns 1 if process a leaves memory before process b
+int completesBefore(process * a, process * b) {
+     return (completionTime(a) < completionTime(b)) ||
+          (completionTime(a) == completionTime(b) && a->pid < b->pid);
+}
+
+// the completion heap keeps every process' slot up to date so a suspended process can be taken out of it
+void completionSwap(scheduler * schedPtr, int i, int j) {
+     process ** heap = schedPtr->completionHeap;
+     process * temp = heap[i];
+     heap[i] = heap[j];
+     heap[j] = temp;
+     heap[i]->completionSlot = i;
+     heap[j]->completionSlot = j;
+}
+
+void completionSiftUp(scheduler * schedPtr, int i) {
+     process ** heap = schedPtr->completionHeap;
+     while (i > 0 && completesBefore(heap[i], heap[(i - 1) / 2])) {
+          completionSwap(schedPtr, i, (i - 1) / 2);
+          i = (i - 1) / 2;
+     }
+}
+
+void completionSiftDown(scheduler * schedPtr, int i) {
+     process ** heap = schedPtr->completionHeap;
+     while (1) {
+          int best = i;
+          int left = 2 * i + 1;
+          int right = left + 1;
+          if (left < schedPtr->completionHeapSize && completesBefore(heap[left], heap[best]))
+               best = left;
+          if (right < schedPtr->completionHeapSize && completesBefore(heap[right], heap[best]))
+               best = right;
+          if (best == i)
+               break;
+          completionSwap(schedPtr, i, best);
+          i = best;
+     }
+}
+
+void completionInsert(scheduler * schedPtr, process * procPtr) {
+     int i = schedPtr->completionHeapSize++;
+     schedPtr->completionHeap[i] = procPtr;
+     procPtr->completionSlot = i;
+     completionSiftUp(schedPtr, i);
+}
+
+void completionRemove(scheduler * schedPtr, process * procPtr) {
+     int i = procPtr->completionSlot;
+     int last = --schedPtr->completionHeapSize;
+     if (i != last) {
+          schedPtr->completionHeap[i] = schedPtr->completionHeap[last];
+          schedPtr->completionHeap[i]->completionSlot = i;
+          completionSiftDown(schedPtr, i);
+          completionSiftUp(schedPtr, i);
+     }
+     procPtr->completionSlot = -1;
+}
+
+// inserts the process into a pid ordered array of processes
+void insertByPid(process ** procs, int * count, process * procPtr) {
+     int i = *count;
+     while (i > 0 && procs[i - 1]->pid > procPtr->pid) {
+          procs[i] = procs[i - 1];
+          --i;
+     }
+     procs[i] = procPtr;
+     ++*count;
+}
+
+// adds a freshly started process to the run queue and the completion heap
+void scheduleProcess(scheduler * schedPtr, process * procPtr) {
+     if (schedPtr->runQueueSize + schedPtr->suspendedCount == schedPtr->capacity) {
+          schedPtr->capacity *= 2;
+          schedPtr->completionHeap = realloc(schedPtr->completionHeap, sizeof(process *) * schedPtr->capacity);
+          schedPtr->runQueue = realloc(schedPtr->runQueue, sizeof(process *) * schedPtr->capacity);
+          schedPtr->suspended = realloc(schedPtr->suspended, sizeof(process *) * schedPtr->capacity);
+     }
+
+     // admission follows the arrival order, which is also pid order, so appending keeps the queue sorted
+     schedPtr->runQueue[schedPtr->runQueueSize++] = procPtr;
+     completionInsert(schedPtr, procPtr);
+}
+
+// removes and returns the process that completes first
+process * popCompletion(scheduler * schedPtr) {
+     process * top = schedPtr->completionHeap[0];
+     completionRemove(schedPtr, top);
+     return top;
+}
+
+// returns the number of free pages a new job finds in the lane, in sharded memory
+// the free pages of the shard it would be given
+int roomForNewJob(ram * ramPtr) {
+     if (ramPtr->shards)
+          return roomiestShard(ramPtr)->allocator.freeFrameCount;
+     return numberOfFreePages(ramPtr);
+}
+
+// returns the number of free pages a new job finds in the fullest lane
+int fewestFreePages(ram * ramPtr) {
+     int fewest = roomForNewJob(ramPtr);
+     for (ramPtr = ramPtr->nextLane; ramPtr; ramPtr = ramPtr->nextLane) {
+          if (roomForNewJob(ramPtr) < fewest)
+               fewest = roomForNewJob(ramPtr);
+     }
+     return fewest;
+}
+
+// returns 1 if the load controller of any lane sees memory overcommitted
+// fault rates are only judged once the windows hold a full window's worth of references
+int memoryOverloaded(ram * ramPtr) {
+     for (; ramPtr; ramPtr = ramPtr->nextLane) {
+          if (ramPtr->loadControl == LOAD_WORKING_SET && ramPtr->workingSetTotal > ramPtr->numberOfFrames)
+               return 1;
+          if (ramPtr->loadControl == LOAD_PFF && ramPtr->windowReferences >= ramPtr->windowTicks &&
+               ramPtr->windowFaults * 100 > ramPtr->pffHigh * ramPtr->windowReferences)
+               return 1;
+     }
+     return 0;
+}
+
+// returns 1 if every lane has room for the process, NULL standing for a new job whose working set is
+// not known yet and is assumed to be the smallest process
+int memoryHasRoom(ram * ramPtr, process * procPtr) {
+     for (; ramPtr; ramPtr = ramPtr->nextLane, procPtr = procPtr ? procPtr->nextLane : NULL) {
+          int workingSet = procPtr ? procPtr->workingSetSize : MIN_PROCESS_PAGES;
+          if (ramPtr->loadControl == LOAD_WORKING_SET && ramPtr->workingSetTotal + workingSet > ramPtr->numberOfFrames)
+               return 0;
+          if (ramPtr->loadControl == LOAD_PFF && ramPtr->windowReferences >= ramPtr->windowTicks &&
+               ramPtr->windowFaults * 100 >= ramPtr->pffLow * ramPtr->windowReferences)
+               return 0;
+     }
+     return 1;
+}
+
+// swaps the process at the given run queue position out of memory in every lane until the load drops
+void suspendProcess(scheduler * schedPtr, int position, ram * ramPtr, int time) {
+     process * procPtr = schedPtr->runQueue[position];
+     memmove(&schedPtr->runQueue[position], &schedPtr->runQueue[position + 1],
+          sizeof(process *) * (schedPtr->runQueueSize - position - 1));
+     --schedPtr->runQueueSize;
+     completionRemove(schedPtr, procPtr);
+     insertByPid(schedPtr->suspended, &schedPtr->suspendedCount, procPtr);
+
+     for (; procPtr; procPtr = procPtr->nextLane, ramPtr = ramPtr->nextLane) {
+          swapOutProcess(procPtr, ramPtr, time);
+          procPtr->suspendedAt = time;
+          ramPtr->thrashing.suspensions += 1;
+     }
+}
+
+// lets the oldest suspended process run again, its pages fault back in on demand
+void resumeProcess(scheduler * schedPtr, int time) {
+     process * procPtr = schedPtr->suspended[0];
+     memmove(&schedPtr->suspended[0], &schedPtr->suspended[1], sizeof(process *) * --schedPtr->suspendedCount);
+     insertByPid(schedPtr->runQueue, &schedPtr->runQueueSize, procPtr);
+
+     process * lanePtr = procPtr;
+     for (; lanePtr; lanePtr = lanePtr->nextLane) {
+          lanePtr->suspendedTicks += time - lanePtr->suspendedAt;
+          lanePtr->suspendedAt = -1;
+          lanePtr->workingSetSize = 0;
+     }
+     completionInsert(schedPtr, procPtr);
+}
+
+// working-set and page-fault-frequency load control: while memory is overcommitted the most recently
+// admitted process is suspended, one per tick and never the last one running, and once the load has
+// dropped the oldest suspended process is resumed
+void controlLoad(scheduler * schedPtr, ram * ramPtr, int time) {
+     if (ramPtr->loadControl == LOAD_NONE)
+          return;
+     if (memoryOverloaded(ramPtr)) {
+          // completed processes wait in the run queue until the next reference pass
+          int newest = schedPtr->runQueueSize - 1;
+          while (newest >= 0 && processCompleted(schedPtr->runQueue[newest], time))
+               --newest;
+          int other = newest - 1;
+          while (other >= 0 && processCompleted(schedPtr->runQueue[other], time))
+               --other;
+          if (other >= 0)
+               suspendProcess(schedPtr, newest, ramPtr, time);
+     }
+     else if (schedPtr->suspendedCount > 0 && fewestFreePages(ramPtr) >= 4 &&
+          memoryHasRoom(ramPtr, schedPtr->suspended[0]) && schedPtr->suspended[0]->suspendedAt < time) {
+          resumeProcess(schedPtr, time);
+     }
+}
+
+// returns 1 if the load controller keeps new jobs out, suspended processes go back in first
+int admissionHeldBack(scheduler * schedPtr, ram * ramPtr) {
+     if (ramPtr->loadControl == LOAD_NONE)
+          return 0;
+     return schedPtr->suspendedCount > 0 || memoryOverloaded(ramPtr) || !memoryHasRoom(ramPtr, NULL);
+}
+
+// brings in jobs that have arrived into memory if there is room for them in every lane
+// memory only fills up while admitting, so the first job that does not fit blocks all later arrivals
+void bringInWaitingJobs(scheduler * schedPtr, ram * ramPtr, int time) {
+     jobSource * sourcePtr = schedPtr->sourcePtr;
+     while (sourcePtr->jobsLeft > 0 && (sourcePtr->next.arrivalTime < time) && (fewestFreePages(ramPtr) >= 4)) {
+          if (admissionHeldBack(schedPtr, ramPtr)) {
+               ram * lanePtr = ramPtr;
+               for (; lanePtr; lanePtr = lanePtr->nextLane)
+                    lanePtr->thrashing.heldBackTicks += 1;
+               break;
+          }
+          // every lane runs its own copy of the job
+          process * headPtr = NULL;
+          process * prevPtr = NULL;
+          ram * lanePtr = ramPtr;
+          for (; lanePtr; lanePtr = lanePtr->nextLane) {
+               process * procPtr = acquireProcess(lanePtr, &sourcePtr->next, sourcePtr->cfg);
+               if (prevPtr)
+                    prevPtr->nextLane = procPtr;
+               else
+                    headPtr = procPtr;
+               prevPtr = procPtr;
+               startProcess(procPtr, lanePtr, time);
+          }
+          scheduleProcess(schedPtr, headPtr);
+          drawNextJob(sourcePtr);
+     }
+     if (metricsOn())
+          noteQueuedJobs(sourcePtr, time);
+}
+
+// takes all jobs that are have run for their service time out of memory
+// they are dropped from the run queue during the next reference pass
+void kickOutCompletedJobs(scheduler * schedPtr, ram * ramPtr, int time) {
+     while (schedPtr->completionHeapSize > 0 && completionTime(schedPtr->completionHeap[0]) <= time) {
+          process * procPtr = popCompletion(schedPtr);
+          ram * lanePtr = ramPtr;
+          for (; procPtr; procPtr = procPtr->nextLane, lanePtr = lanePtr->nextLane)
+               stopProcess(procPtr, lanePtr, time);
+     }
+}
+
+// adds a process to the ones referencing in the shard this tick
+void queueShardWork(frameShard * shardPtr, process * procPtr) {
+     if (shardPtr->workCount == shardPtr->workCapacity) {
+          process ** grown = arenaAlloc(shardPtr->ownerPtr->arenaPtr, sizeof(process *) * shardPtr->workCapacity * 2);
+          memcpy(grown, shardPtr->work, sizeof(process *) * shardPtr->workCount);
+          shardPtr->work = grown;
+          shardPtr->workCapacity *= 2;
+     }
+     shardPtr->work[shardPtr->workCount++] = procPtr;
+}
+
+// has the processes queued on the shard reference one page each, in pid order
+POLICY_CORE void runShardWorkFor(frameShard * shardPtr, ram * ramPtr, int time, policy compiled) {
+     int i;
+     for (i = 0; i < shardPtr->workCount; ++i)
+          serviceReferenceFor(shardPtr->work[i], ramPtr, time, compiled);
+     shardPtr->workCount = 0;
+}
+
+// runs the references of shards 1 and up, one shard per thread, a tick at a time
+void * shardWorker(void * arg) {
+     frameShard * shardPtr = arg;
+     ram * ramPtr = shardPtr->ownerPtr;
+     shardPool * poolPtr = ramPtr->poolPtr;
+     for (;;) {
+          pthread_barrier_wait(&poolPtr->start);
+          if (poolPtr->stopping)
+               break;
+          poolPtr->runShardWork(shardPtr, ramPtr, poolPtr->time);
+          pthread_barrier_wait(&poolPtr->finish);
+     }
+     return NULL;
+}
+
+// runs the queued references of every shard side by side, the trial's own thread taking shard 0,
+// then counts the tick's faults
+// the shards share no frames and no processes, so their results do not depend on how the threads interleave
+POLICY_CORE void runShardsFor(ram * ramPtr, int time, policy compiled) {
+     shardPool * poolPtr = ramPtr->poolPtr;
+     if (poolPtr) {
+          poolPtr->time = time;
+          pthread_barrier_wait(&poolPtr->start);
+     }
+     runShardWorkFor(&ramPtr->shards[0], ramPtr, time, compiled);
+     if (poolPtr)
+          pthread_barrier_wait(&poolPtr->finish);
+     int i;
+     for (i = 0; i < ramPtr->numberOfShards; ++i) {
+          frameShard * shardPtr = &ramPtr->shards[i];
+          if (shardPtr->tickFaults > 0)
+               countFault(&ramPtr->thrashing, ramPtr->trialTicks, time, shardPtr->tickFaults);
+          shardPtr->tickFaults = 0;
+     }
+}
+
+// has every running process reference one page, compacting finished processes out of the run queue
+// and handing them back for reuse
+POLICY_CORE void runReferencesFor(scheduler * schedPtr, ram * ramPtr, int time, policy compiled) {
+     int kept = 0;
+     int i;
+     for (i = 0; i < schedPtr->runQueueSize; ++i) {
+          process * procPtr = schedPtr->runQueue[i];
+          if (processCompleted(procPtr, time)) {
+               ram * lanePtr = ramPtr;
+               for (; procPtr; procPtr = procPtr->nextLane, lanePtr = lanePtr->nextLane)
+                    releaseProcess(procPtr, lanePtr);
+               continue;
+          }
+          schedPtr->runQueue[kept++] = procPtr;
+          if (processStarted(procPtr, time - 1) && procPtr->blockedUntil < time) {
+               if (procPtr->shardPtr)
+                    queueShardWork(procPtr->shardPtr, procPtr);
+               else
+                    serviceReferenceFor(procPtr, ramPtr, time, compiled);
+          }
+     }
+     schedPtr->runQueueSize = kept;
+     if (ramPtr->shards)
+          runShardsFor(ramPtr, time, compiled);
+}
+          
+void printVisualDivider() {
+     int i = 0;
+     printf("\n");
+     for (i = 0; i < 80; ++i) 
+          printf("=");   // this is just for a clearer section break
+     printf("\n");
+}
+
+void printUsage(char * programName) {
+     printf("usage: %s [-f frames] [-s sizes] [-j threads] [-r seed] [-m] [-c frames] [-w file | -p file]\n"
+          "       [-v level] [-l limit] [-e interval] [-o file | -F file] [-b] [-k kernel]\n"
+          "       [-g] [-a control] [-W references] [-H percent] [-L percent] [-T] [-P pages] [-D ticks] [-Q reads]\n"
+          "       [-n jobs] [-d seconds] [-t workloads] [-x percent] [-S file] [-O file] [-R format] [-B] [-K seconds]\n"
+          "       [-z shards] [-y file | -i file] [-M file] [-N format] [-G] [-V]\n", programName);
+     printf("  -f, --frames N          number of physical pages in memory (default %d)\n", DEFAULT_NUM_FRAMES);
+     printf("  -s, --sizes N[,N...]    process sizes in pages, picked uniformly (default 5,11,17,31)\n");
+     printf("  -j, --threads N         number of trials run concurrently (default: number of cores)\n");
+     printf("  -r, --seed N            master random seed (default %d)\n", DEFAULT_SEED);
+     printf("  -m, --shared            run all policies side by side on one shared reference stream\n");
+     printf("  -c, --mrc N             print the global LRU miss ratio curve for 1..N frames instead of simulating;\n"
+          "                          compare it with -g runs\n");
+     printf("  -w, --record FILE       simulate every workload under LRU and write its binary trace to FILE\n");
+     printf("  -p, --replay FILE       replay a recorded trace under every policy instead of generating workloads\n");
+     printf("  -v, --verbosity N       event log level of traced trials: 0 off, 1 swaps, 2 swaps and references (default 2)\n");
+     printf("  -l, --log-limit N       stop logging a trial after N references, 0 for no limit (default %d)\n", DEFAULT_LOG_LIMIT);
+     printf("  -e, --log-sample N      log one in every N references (default 1)\n");
+     printf("  -o, --log FILE          write the binary event log to FILE instead of printing it\n");
+     printf("  -F, --format-log FILE   print a binary event log written with --log and exit\n");
+     printf("  -b, --bench-layout      time LRU victim scans over per-page structs and per-frame arrays and exit\n");
+     printf("  -k, --scan-kernel NAME  frame scan kernel of -V and -b: scalar, sse4, avx2 or avx512\n"
+          "                          (default: widest supported)\n");
+     printf("  -g, --global            replace pages globally, a fault may evict a page of any process\n");
+     printf("  -a, --load-control MODE suspend and hold back jobs by working set (ws) or fault frequency (pff) (default none)\n");
+     printf("  -W, --window N          working-set window of the load controller in references of each process (default %d)\n", DEFAULT_WINDOW_TICKS);
+     printf("  -H, --pff-high P        fault percentage above which pff suspends a process (default %d)\n", DEFAULT_PFF_HIGH);
+     printf("  -L, --pff-low P         fault percentage below which pff admits or resumes a process (default %d)\n", DEFAULT_PFF_LOW);
+     printf("  -T, --thrashing         print fault rates, suspensions and held back jobs of every trial\n");
+     printf("  -P, --prefetch N        pages read ahead once a process references pages sequentially (default 0)\n");
+     printf("  -D, --disk-latency N    ticks a disk read takes (default 0)\n");
+     printf("  -Q, --queue-depth N     reads the disk serves at once (default %d)\n", DEFAULT_QUEUE_DEPTH);
+     printf("  -n, --jobs N            jobs arriving in every workload (default %d)\n", DEFAULT_NUM_JOBS);
+     printf("  -d, --duration N        simulated seconds every trial runs for (default %d)\n", DEFAULT_TRIAL_SECONDS);
+     printf("  -t, --trials N          workloads every policy is run on (default %d)\n", DEFAULT_NUM_WORKLOADS);
+     printf("  -x, --locality P        percentage of references on or next to the last page (default %d)\n",
+          DEFAULT_LOCALITY_PERCENT);
+     printf("  -S, --sweep FILE        run every point of the grid in FILE: lines of frames, locality, sizes or policy\n"
+          "                          followed by the values of that axis\n");
+     printf("  -O, --results FILE      write the results to FILE, a sweep resumes from the rows already in it\n");
+     printf("  -R, --format FORMAT     results as text, csv or json lines (default text, csv with -S or -O)\n");
+     printf("  -B, --bench             time every policy at several memory and process sizes and exit\n");
+     printf("  -K, --fork-at N         warm every workload up under %s for N seconds, then fork it into one trial\n"
+          "                          per policy; statistics cover the rest of the run\n", policyNames[FORK_WARMUP_POLICY]);
+     printf("  -z, --shards N          split every trial's memory into N pools of frames, each run on its own thread;\n"
+          "                          a process faults only into the pool it was admitted to (default: one pool)\n");
+     printf("  -y, --save-workloads FILE write the jobs of every workload to FILE and exit\n");
+     printf("  -i, --workloads FILE    run the workloads saved in FILE; its workload count, jobs, duration and\n"
+          "                          sizes replace -t, -n, -d and -s\n");
+     printf("  -M, --metrics FILE      stream a row per tick (faults, free frames, running and queued jobs) and per\n"
+          "                          finished process (wait, hits, misses, fault latency histogram) of every trial\n"
+          "                          to FILE; trials run side by side write their rows in interleaved blocks\n");
+     printf("  -N, --metrics-format F  metrics as csv rows or binary records (default csv)\n");
+     printf("  -G, --generic-core      run the tick loop compiled for any policy instead of the one specialized\n"
+          "                          for each policy; results are the same, only slower\n");
+     printf("  -V, --victim-scan       find FIFO, LRU, LFU and MFU victims with vectorized scans of per-frame arrays\n"
+          "                          of their keys instead of keeping sorted lists and heaps; results are the same\n");
+}
+
+// parses a strictly positive integer option argument, exits on malformed input
+int parsePositiveInt(char * arg, char * optionName) {
+     char * end;
+     long value = strtol(arg, &end, 10);
+     if (*arg == '\0' || *end != '\0' || value <= 0 || value > 0x7fffffff) {
+          printf("ERROR INVALID VALUE FOR %s: %s\n", optionName, arg);
+          exit(1);
+     }
+     return (int)value;
+}
+
+// parses a locality percentage, 0 to 100
+int parseLocality(char * arg) {
+     char * end;
+     long value = strtol(arg, &end, 10);
+     if (*arg == '\0' || *end != '\0' || value < 0 || value > 100) {
+          printf("ERROR INVALID VALUE FOR locality: %s\n", arg);
+          exit(1);
+     }
+     return (int)value;
+}
+
+// parses a comma separated list of process sizes into the configuration
+void parseProcessSizes(char * arg, config * cfg) {
+     char * token = arg;
+     cfg->numberOfProcessSizes = 0;
+     while (token) {
+          char * comma = strchr(token, ',');
+          if (comma)
+               *comma = '\0';
+          if (cfg->numberOfProcessSizes == MAX_PROCESS_SIZES) {
+               printf("ERROR TOO MANY PROCESS SIZES, AT MOST %d\n", MAX_PROCESS_SIZES);
+               exit(1);
+          }
+          int size = parsePositiveInt(token, "sizes");
+          if (size < MIN_PROCESS_PAGES) {
+               printf("ERROR PROCESS SIZE %d IS BELOW THE MINIMUM OF %d PAGES\n", size, MIN_PROCESS_PAGES);
+               exit(1);
+          }
+          cfg->processSizes[cfg->numberOfProcessSizes++] = size;
+          token = comma ? comma + 1 : NULL;
+     }
+}
+
+// fills the configuration from the command line, falling back to the defaults
+void parseArguments(int argc, char ** argv, config * cfg) {
+     static struct option longOptions[] = {
+          {"frames", required_argument, NULL, 'f'},
+          {"sizes",  required_argument, NULL, 's'},
+          {"threads", required_argument, NULL, 'j'},
+          {"seed",   required_argument, NULL, 'r'},
+          {"shared", no_argument,       NULL, 'm'},
+          {"mrc",    required_argument, NULL, 'c'},
+          {"record", required_argument, NULL, 'w'},
+          {"replay", required_argument, NULL, 'p'},
+          {"verbosity", required_argument, NULL, 'v'},
+          {"log-limit", required_argument, NULL, 'l'},
+          {"log-sample", required_argument, NULL, 'e'},
+          {"log",    required_argument, NULL, 'o'},
+          {"format-log", required_argument, NULL, 'F'},
+          {"bench-layout", no_argument,   NULL, 'b'},
+          {"scan-kernel", required_argument, NULL, 'k'},
+          {"global", no_argument,       NULL, 'g'},
+          {"load-control", required_argument, NULL, 'a'},
+          {"window", required_argument, NULL, 'W'},
+          {"pff-high", required_argument, NULL, 'H'},
+          {"pff-low", required_argument, NULL, 'L'},
+          {"thrashing", no_argument,    NULL, 'T'},
+          {"prefetch", required_argument, NULL, 'P'},
+          {"disk-latency", required_argument, NULL, 'D'},
+          {"queue-depth", required_argument, NULL, 'Q'},
+          {"jobs",   required_argument, NULL, 'n'},
+          {"duration", required_argument, NULL, 'd'},
+          {"trials", required_argument, NULL, 't'},
+          {"locality", required_argument, NULL, 'x'},
+          {"sweep",  required_argument, NULL, 'S'},
+          {"results", required_argument, NULL, 'O'},
+          {"format", required_argument, NULL, 'R'},
+          {"bench",  no_argument,       NULL, 'B'},
+          {"fork-at", required_argument, NULL, 'K'},
+          {"shards", required_argument, NULL, 'z'},
+          {"save-workloads", required_argument, NULL, 'y'},
+          {"workloads", required_argument, NULL, 'i'},
+          {"metrics", required_argument, NULL, 'M'},
+          {"metrics-format", required_argument, NULL, 'N'},
+          {"generic-core", no_argument, NULL, 'G'},
+          {"victim-scan", no_argument, NULL, 'V'},
+          {"help",   no_argument,       NULL, 'h'},
+          {NULL, 0, NULL, 0}
+     };
+
+     int defaultSizes[] = {5, 11, 17, 31};
+     long cores = sysconf(_SC_NPROCESSORS_ONLN);
+     cfg->numberOfFrames = DEFAULT_NUM_FRAMES;
+     cfg->numberOfThreads = cores > 0 ? (int)cores : 1;
+     cfg->seed = DEFAULT_SEED;
+     cfg->sharedReferences = 0;
+     cfg->mrcFrames = 0;
+     cfg->recordPath = NULL;
+     cfg->replayPath = NULL;
+     cfg->logVerbosity = LOG_REFERENCES;
+     cfg->logLimit = DEFAULT_LOG_LIMIT;
+     cfg->logSampleInterval = 1;
+     cfg->logPath = NULL;
+     cfg->formatLogPath = NULL;
+     cfg->benchLayout = 0;
+     cfg->benchSuite = 0;
+     cfg->forkSeconds = -1;
+     cfg->numberOfShards = 0;
+     cfg->saveWorkloadsPath = NULL;
+     cfg->workloadsPath = NULL;
+     cfg->workloadsPtr = NULL;
+     cfg->metricsPath = NULL;
+     cfg->metricsBinary = 0;
+     cfg->metricsSinkPtr = NULL;
+     cfg->genericCore = 0;
+     cfg->victimScan = 0;
+     cfg->scanKernel = NULL;
+     cfg->globalScope = 0;
+     cfg->loadControl = LOAD_NONE;
+     cfg->windowTicks = DEFAULT_WINDOW_TICKS;
+     cfg->pffHigh = DEFAULT_PFF_HIGH;
+     cfg->pffLow = DEFAULT_PFF_LOW;
+     cfg->reportThrashing = 0;
+     cfg->prefetchDepth = 0;
+     cfg->diskLatency = 0;
+     cfg->queueDepth = DEFAULT_QUEUE_DEPTH;
+     cfg->numberOfJobs = DEFAULT_NUM_JOBS;
+     cfg->numberOfWorkloads = DEFAULT_NUM_WORKLOADS;
+     cfg->trialSeconds = DEFAULT_TRIAL_SECONDS;
+     cfg->localityPercent = DEFAULT_LOCALITY_PERCENT;
+     cfg->sweepPath = NULL;
+     cfg->resultsPath = NULL;
+     cfg->resultsFormat = RESULTS_TEXT;
+     int formatGiven = 0;
+     cfg->numberOfProcessSizes = 4;
+     memcpy(cfg->processSizes, defaultSizes, sizeof(defaultSizes));
+
+     int opt;
+     while ((opt = getopt_long(argc, argv, "f:s:j:r:mc:w:p:v:l:e:o:F:bk:ga:W:H:L:TP:D:Q:n:d:t:x:S:O:R:BK:z:y:i:M:N:GVh", longOptions, NULL)) != -1) {
+          switch (opt) {
+               case 'f':
+                    cfg->numberOfFrames = parsePositiveInt(optarg, "frames");
+                    break;
+               case 's':
+                    parseProcessSizes(optarg, cfg);
+                    break;
+               case 'j':
+                    cfg->numberOfThreads = parsePositiveInt(optarg, "threads");
+                    break;
+               case 'r':
+                    cfg->seed = strtoull(optarg, NULL, 10);
+                    break;
+               case 'm':
+                    cfg->sharedReferences = 1;
+                    break;
+               case 'c':
+                    cfg->mrcFrames = parsePositiveInt(optarg, "mrc");
+                    break;
+               case 'w':
+                    cfg->recordPath = optarg;
+                    break;
+               case 'p':
+                    cfg->replayPath = optarg;
+                    break;
+               case 'v':
+                    cfg->logVerbosity = atoi(optarg);
+                    if (cfg->logVerbosity < LOG_OFF || cfg->logVerbosity > LOG_REFERENCES) {
+                         printf("ERROR INVALID VALUE FOR verbosity: %s\n", optarg);
+                         exit(1);
+                    }
+                    break;
+               case 'l':
+                    cfg->logLimit = atoll(optarg);
+                    if (cfg->logLimit <= 0)
+                         cfg->logLimit = 0x7fffffffffffffffLL;
+                    break;
+               case 'e':
+                    cfg->logSampleInterval = parsePositiveInt(optarg, "log-sample");
+                    break;
+               case 'o':
+                    cfg->logPath = optarg;
+                    break;
+               case 'F':
+                    cfg->formatLogPath = optarg;
+                    break;
+               case 'b':
+                    cfg->benchLayout = 1;
+                    break;
+               case 'B':
+                    cfg->benchSuite = 1;
+                    break;
+               case 'K':
+                    cfg->forkSeconds = atoi(optarg);
+                    if (cfg->forkSeconds < 0) {
+                         printf("ERROR INVALID VALUE FOR fork-at: %s\n", optarg);
+                         exit(1);
+                    }
+                    break;
+               case 'z':
+                    cfg->numberOfShards = parsePositiveInt(optarg, "shards");
+                    break;
+               case 'y':
+                    cfg->saveWorkloadsPath = optarg;
+                    break;
+               case 'i':
+                    cfg->workloadsPath = optarg;
+                    break;
+               case 'M':
+                    cfg->metricsPath = optarg;
+                    break;
+               case 'N':
+                    if (strcmp(optarg, "csv") == 0)
+                         cfg->metricsBinary = 0;
+                    else if (strcmp(optarg, "binary") == 0)
+                         cfg->metricsBinary = 1;
+                    else {
+                         printf("ERROR INVALID VALUE FOR metrics-format: %s\n", optarg);
+                         exit(1);
+                    }
+                    break;
+               case 'G':
+                    cfg->genericCore = 1;
+                    break;
+               case 'V':
+                    cfg->victimScan = 1;
+                    break;
+               case 'k':
+                    cfg->scanKernel = optarg;
+                    break;
+               case 'g':
+                    cfg->globalScope = 1;
+                    break;
+               case 'a':
+                    if (strcmp(optarg, "none") == 0)
+                         cfg->loadControl = LOAD_NONE;
+                    else if (strcmp(optarg, "ws") == 0)
+                         cfg->loadControl = LOAD_WORKING_SET;
+                    else if (strcmp(optarg, "pff") == 0)
+                         cfg->loadControl = LOAD_PFF;
+                    else {
+                         printf("ERROR INVALID VALUE FOR load-control: %s\n", optarg);
+                         exit(1);
+                    }
+                    break;
+               case 'W':
+                    cfg->windowTicks = parsePositiveInt(optarg, "window");
+                    break;
+               case 'H':
+                    cfg->pffHigh = parsePositiveInt(optarg, "pff-high");
+                    break;
+               case 'L':
+                    cfg->pffLow = parsePositiveInt(optarg, "pff-low");
+                    break;
+               case 'T':
+                    cfg->reportThrashing = 1;
+                    break;
+               case 'P':
+                    cfg->prefetchDepth = parsePositiveInt(optarg, "prefetch");
+                    break;
+               case 'D':
+                    cfg->diskLatency = parsePositiveInt(optarg, "disk-latency");
+                    break;
+               case 'Q':
+                    cfg->queueDepth = parsePositiveInt(optarg, "queue-depth");
+                    break;
+               case 'n':
+                    cfg->numberOfJobs = parsePositiveInt(optarg, "jobs");
+                    break;
+               case 'd':
+                    cfg->trialSeconds = parsePositiveInt(optarg, "duration");
+                    break;
+               case 't':
+                    cfg->numberOfWorkloads = parsePositiveInt(optarg, "trials");
+                    break;
+               case 'x':
+                    cfg->localityPercent = parseLocality(optarg);
+                    break;
+               case 'S':
+                    cfg->sweepPath = optarg;
+                    break;
+               case 'O':
+                    cfg->resultsPath = optarg;
+                    break;
+               case 'R':
+                    if (strcmp(optarg, "text") == 0)
+                         cfg->resultsFormat = RESULTS_TEXT;
+                    else if (strcmp(optarg, "csv") == 0)
+                         cfg->resultsFormat = RESULTS_CSV;
+                    else if (strcmp(optarg, "json") == 0)
+                         cfg->resultsFormat = RESULTS_JSON;
+                    else {
+                         printf("ERROR INVALID VALUE FOR format: %s\n", optarg);
+                         exit(1);
+                    }
+                    formatGiven = 1;
+                    break;
+               case 'h':
+                    printUsage(argv[0]);
+                    exit(0);
+               default:
+                    printUsage(argv[0]);
+                    exit(1);
+          }
+     }
+     if (cfg->workloadsPath && (cfg->saveWorkloadsPath || cfg->replayPath || cfg->benchSuite)) {
+          printf("ERROR --workloads CANNOT BE COMBINED WITH --save-workloads, --replay OR --bench\n");
+          exit(1);
+     }
+     if (cfg->workloadsPath)
+          loadWorkloads(cfg);
+     if (cfg->metricsPath && !METRICS_ENABLED) {
+          printf("ERROR --metrics WAS COMPILED OUT, REBUILD WITH METRICS_ENABLED SET TO 1\n");
+          exit(1);
+     }
+     if (cfg->metricsPath && (cfg->sharedReferences || cfg->mrcFrames > 0 || cfg->recordPath || cfg->replayPath
+          || cfg->sweepPath || cfg->forkSeconds >= 0 || cfg->benchSuite)) {
+          printf("ERROR --metrics CANNOT BE COMBINED WITH --shared, --mrc, --record, --replay, --sweep, --fork-at\n"
+               "      OR --bench\n");
+          exit(1);
+     }
+     if (cfg->sharedReferences && cfg->diskLatency > 0) {
+          // a process blocked on the disk in one lane would fall out of step with the others
+          printf("ERROR --disk-latency CANNOT BE COMBINED WITH --shared\n");
+          exit(1);
+     }
+     if (!formatGiven && (cfg->sweepPath || cfg->resultsPath))
+          cfg->resultsFormat = RESULTS_CSV;
+     if (cfg->resultsFormat == RESULTS_TEXT && (cfg->sweepPath || cfg->resultsPath)) {
+          printf("ERROR --sweep AND --results WRITE csv OR json\n");
+          exit(1);
+     }
+     if (cfg->resultsFormat != RESULTS_TEXT && (cfg->mrcFrames > 0 || cfg->recordPath)) {
+          printf("ERROR --mrc AND --record HAVE NO csv OR json RESULTS\n");
+          exit(1);
+     }
+     if (cfg->sweepPath && (cfg->sharedReferences || cfg->mrcFrames > 0 || cfg->recordPath || cfg->replayPath)) {
+          printf("ERROR --sweep CANNOT BE COMBINED WITH --shared, --mrc, --record OR --replay\n");
+          exit(1);
+     }
+     if (cfg->forkSeconds >= 0 && (cfg->sharedReferences || cfg->mrcFrames > 0 || cfg->recordPath
+          || cfg->replayPath || cfg->sweepPath)) {
+          printf("ERROR --fork-at CANNOT BE COMBINED WITH --shared, --mrc, --record, --replay OR --sweep\n");
+          exit(1);
+     }
+     if (cfg->numberOfShards > 1 && (cfg->globalScope || cfg->loadControl != LOAD_NONE || cfg->prefetchDepth > 0
+          || cfg->diskLatency > 0 || cfg->sharedReferences || cfg->mrcFrames > 0 || cfg->recordPath || cfg->replayPath)) {
+          // every one of these touches state that all processes of a memory share on every reference
+          printf("ERROR --shards CANNOT BE COMBINED WITH --global, --load-control, --prefetch, --disk-latency,\n"
+               "      --shared, --mrc, --record OR --replay\n");
+          exit(1);
+     }
+     if (cfg->numberOfShards > cfg->numberOfFrames) {
+          printf("ERROR %d FRAMES CANNOT BE SPLIT INTO %d SHARDS\n", cfg->numberOfFrames, cfg->numberOfShards);
+          exit(1);
+     }
+     if (cfg->forkSeconds >= cfg->trialSeconds) {
+          printf("ERROR --fork-at MUST FALL BEFORE THE END OF THE %d SECOND TRIAL\n", cfg->trialSeconds);
+          exit(1);
+     }
+     if (cfg->trialSeconds > MAX_TRIAL_TICKS / TICKS_PER_SECOND) {
+          // tick times are ints
+          printf("ERROR A TRIAL CAN RUN FOR AT MOST %d SECONDS\n", MAX_TRIAL_TICKS / TICKS_PER_SECOND);
+          exit(1);
+     }
+     if (cfg->numberOfWorkloads > 0x7fffffff / NUM_POLICIES) {
+          printf("ERROR INVALID VALUE FOR trials: %d\n", cfg->numberOfWorkloads);
+          exit(1);
+     }
+     if (cfg->recordPath && cfg->numberOfWorkloads > TRACE_MAX_SEGMENTS) {
+          printf("ERROR A TRACE HOLDS AT MOST %d WORKLOADS\n", TRACE_MAX_SEGMENTS);
+          exit(1);
+     }
+     if (cfg->pffLow > cfg->pffHigh || cfg->pffHigh > 100) {
+          printf("ERROR PFF THRESHOLDS MUST SATISFY pff-low <= pff-high <= 100\n");
+          exit(1);
+     }
+}
+
+// splits the frame table into shards of consecutive frames whose sizes differ by at most one
+void initShards(ram * ramPtr, int numberOfShards) {
+     if (numberOfShards > ramPtr->numberOfFrames) {
+          printf("ERROR %d FRAMES CANNOT BE SPLIT INTO %d SHARDS\n", ramPtr->numberOfFrames, numberOfShards);
+          exit(1);
+     }
+     ramPtr->numberOfShards = numberOfShards;
+     ramPtr->shards = arenaAlloc(ramPtr->arenaPtr, sizeof(frameShard) * numberOfShards);
+     int i;
+     for (i = 0; i < numberOfShards; ++i) {
+          frameShard * shardPtr = &ramPtr->shards[i];
+          memset(shardPtr, 0, sizeof(frameShard));
+          shardPtr->firstFrame = (int)((long long)i * ramPtr->numberOfFrames / numberOfShards);
+          int nextFirst = (int)((long long)(i + 1) * ramPtr->numberOfFrames / numberOfShards);
+          initFrameAllocator(&shardPtr->allocator, nextFirst - shardPtr->firstFrame, ramPtr->arenaPtr);
+          shardPtr->workCapacity = 64;
+          shardPtr->work = arenaAlloc(ramPtr->arenaPtr, sizeof(process *) * shardPtr->workCapacity);
+          shardPtr->ownerPtr = ramPtr;
+     }
+}
+
+// starts a thread for every shard after the first, they wait for runShards to hand them a tick
+void startShardPool(ram * ramPtr, void (* runShardWork)(frameShard *, ram *, int)) {
+     shardPool * poolPtr = malloc(sizeof(shardPool));
+     poolPtr->runShardWork = runShardWork;
+     poolPtr->threads = malloc(sizeof(pthread_t) * (ramPtr->numberOfShards - 1));
+     pthread_barrier_init(&poolPtr->start, NULL, ramPtr->numberOfShards);
+     pthread_barrier_init(&poolPtr->finish, NULL, ramPtr->numberOfShards);
+     poolPtr->time = 0;
+     poolPtr->stopping = 0;
+     ramPtr->poolPtr = poolPtr;
+     int i;
+     for (i = 1; i < ramPtr->numberOfShards; ++i) {
+          if (pthread_create(&poolPtr->threads[i - 1], NULL, shardWorker, &ramPtr->shards[i]) != 0) {
+               printf("ERROR CREATING SHARD THREAD\n");
+               exit(1);
+          }
+     }
+}
+
+// stops the shard threads and adds the shards' hits and misses to the memory's
+void stopShardPool(ram * ramPtr) {
+     shardPool * poolPtr = ramPtr->poolPtr;
+     int i;
+     if (poolPtr) {
+          poolPtr->stopping = 1;
+          pthread_barrier_wait(&poolPtr->start);
+          for (i = 1; i < ramPtr->numberOfShards; ++i)
+               pthread_join(poolPtr->threads[i - 1], NULL);
+          pthread_barrier_destroy(&poolPtr->start);
+          pthread_barrier_destroy(&poolPtr->finish);
+          free(poolPtr->threads);
+          free(poolPtr);
+          ramPtr->poolPtr = NULL;
+     }
+     for (i = 0; i < ramPtr->numberOfShards; ++i) {
+          ramPtr->hits += ramPtr->shards[i].hits;
+          ramPtr->misses += ramPtr->shards[i].misses;
+          ramPtr->shards[i].hits = 0;
+          ramPtr->shards[i].misses = 0;
+     }
+}
+
+// sets up the replacement scope and load controller a memory simulates under
+void applyMemoryOptions(ram * ramPtr, config * cfg) {
+     ramPtr->globalScope = cfg->globalScope;
+     if (cfg->globalScope)
+          initVictimState(&ramPtr->globalVictims, ramPtr->numberOfFrames, 1, ramPtr->arenaPtr);
+     ramPtr->loadControl = cfg->loadControl;
+     ramPtr->windowTicks = cfg->windowTicks;
+     ramPtr->pffHigh = cfg->pffHigh;
+     ramPtr->pffLow = cfg->pffLow;
+     ramPtr->trialTicks = cfg->trialSeconds * TICKS_PER_SECOND;
+     ramPtr->prefetchDepth = cfg->prefetchDepth;
+     ramPtr->genericCore = cfg->genericCore;
+     ramPtr->victimScan = cfg->victimScan;
+     ramPtr->diskLatency = cfg->diskLatency;
+     ramPtr->queueDepth = cfg->queueDepth;
+     ramPtr->diskBusyUntil = arenaAlloc(ramPtr->arenaPtr, sizeof(int) * cfg->queueDepth);
+     memset(ramPtr->diskBusyUntil, 0, sizeof(int) * cfg->queueDepth);
+     if (cfg->numberOfShards > 0)
+          initShards(ramPtr, cfg->numberOfShards);
+}
+
+// drops whatever a page's replacement policy kept on it, resident or not
+void forgetPolicyState(page * pagePtr) {
+     pagePtr->prevResident = NULL;
+     pagePtr->nextResident = NULL;
+     pagePtr->policyList = LIST_NONE;
+     pagePtr->prevQueued = NULL;
+     pagePtr->nextQueued = NULL;
+     pagePtr->queued = 0;
+     pagePtr->lirsHot = 0;
+     pagePtr->referenceBit = 0;
+     pagePtr->freshlyPagedIn = 0;
+     pagePtr->heapIndex = -1;
+}
+
+// OPT: builds the next-use index of a process that started under another policy, then sets the next use
+// of its resident pages from their latest references. The references the process has made are its hits
+// and misses, and its reference string is replayed from a stream seeded afresh
+void primeNextUse(process * procPtr, ram * ramPtr, arena * arenaPtr) {
+     rng current = procPtr->referenceStream;
+     rngSeed(&procPtr->referenceStream, procPtr->seed, STREAM_REFERENCES);
+     rng stream = procPtr->referenceStream;
+     buildNextUseIndex(procPtr, arenaPtr);
+     procPtr->referenceStream = current;
+
+     int made = procPtr->hitCount + procPtr->missCount;
+     int * lastIndex = malloc(sizeof(int) * procPtr->numberOfPages);
+     int i;
+     for (i = 0; i < procPtr->numberOfPages; ++i)
+          lastIndex[i] = -1;
+     int pageID = 0;
+     for (i = 0; i < made; ++i) {
+          if (i > 0)
+               pageID = nextReferenceID(&stream, pageID, procPtr->numberOfPages, procPtr->localityPercent);
+          lastIndex[pageID] = i;
+     }
+     for (i = 0; i < procPtr->numberOfPages; ++i) {
+          page * pagePtr = &procPtr->pageTable[i];
+          if (pagePtr->inMemory && lastIndex[i] >= 0) {
+               int delta = procPtr->nextUseDelta[lastIndex[i]];
+               pagePtr->nextUse = (delta == INT_MAX) ? INT_MAX :
+                    nextUseAfter(ramPtr, lastIndex[i], pagePtr->timeLastReferenced) + delta;
+          }
+     }
+     free(lastIndex);
+     procPtr->referencesMade = made;
+}
+
+// a resident page and its owner, while the victim structures are rebuilt
+typedef struct _residentPage {
+    process * procPtr;         // owner of the page
+    page * pagePtr;            // the page
+} residentPage;
+
+int compareResidentPages(const void * a, const void * b) {
+     page * x = ((const residentPage *)a)->pagePtr;
+     page * y = ((const residentPage *)b)->pagePtr;
+     if (x->timeLastReferenced != y->timeLastReferenced)
+          return x->timeLastReferenced < y->timeLastReferenced ? -1 : 1;
+     if (x->pid != y->pid)
+          return x->pid < y->pid ? -1 : 1;
+     return x->pageID - y->pageID;
+}
+
+// continues a memory under another replacement policy: the victim structures are rebuilt from scratch
+// and the resident pages handed to the new policy from least to most recently referenced, as if paged
+// in in that order. Ghost lists of the old policy are dropped, the new one starts without history
+void switchPolicy(scheduler * schedPtr, ram * ramPtr, policy newPolicy) {
+     ramPtr->desiredPolicy = newPolicy;
+     int residentCount = ramPtr->numberOfFrames - numberOfFreePages(ramPtr);
+     residentPage * resident = malloc(sizeof(residentPage) * (residentCount + 1));
+     int found = 0;
+     int i;
+     for (i = 0; i < schedPtr->runQueueSize + schedPtr->suspendedCount; ++i) {
+          process * procPtr = (i < schedPtr->runQueueSize) ? schedPtr->runQueue[i]
+               : schedPtr->suspended[i - schedPtr->runQueueSize];
+          clearVictimState(&procPtr->victims);
+          int pageID;
+          for (pageID = 0; pageID < procPtr->numberOfPages; ++pageID) {
+               page * pagePtr = &procPtr->pageTable[pageID];
+               forgetPolicyState(pagePtr);
+               if (pagePtr->inMemory) {
+                    resident[found].procPtr = procPtr;
+                    resident[found++].pagePtr = pagePtr;
+               }
+          }
+          if (newPolicy == OPT)
+               primeNextUse(procPtr, ramPtr, ramPtr->arenaPtr);
+     }
+     if (found != residentCount) {
+          printf("ERROR %d OF %d RESIDENT PAGES BELONG TO NO SCHEDULED PROCESS\n", residentCount - found, residentCount);
+          exit(1);
+     }
+     if (ramPtr->globalScope)
+          clearVictimState(&ramPtr->globalVictims);
+
+     qsort(resident, found, sizeof(residentPage), compareResidentPages);
+     for (i = 0; i < found; ++i) {
+          policyTrackPage(resident[i].procPtr, resident[i].pagePtr, ramPtr);
+          resident[i].pagePtr->freshlyPagedIn = 0;
+     }
+     free(resident);
+}
+
+// advances the simulation through the ticks from up to, not including, to
+POLICY_CORE void runTicksFor(scheduler * schedPtr, ram * ramPtr, int from, int to, policy compiled) {
+     int time;
+     for (time = from; time < to; ++time) {
+          enterPhase(PHASE_KICK_OUT);
+          kickOutCompletedJobs(schedPtr, ramPtr, time);
+          leavePhase();
+          controlLoad(schedPtr, ramPtr, time);
+          enterPhase(PHASE_BRING_IN);
+          bringInWaitingJobs(schedPtr, ramPtr, time);
+          leavePhase();
+
+          runReferencesFor(schedPtr, ramPtr, time, compiled);
+          if (metricsOn())
+               sampleTick(schedPtr, ramPtr, time);
+     }
+}
+
+// one compiled copy of the tick loop, with the shard work it hands its threads
+typedef struct _tickLoop {
+    void (* runTicks)(scheduler * schedPtr, ram * ramPtr, int from, int to);
+    void (* runShardWork)(frameShard * shardPtr, ram * ramPtr, int time);
+} tickLoop;
+
+#define TICK_LOOP(name, compiled) \
+     void runTicks##name(scheduler * schedPtr, ram * ramPtr, int from, int to) { \
+          runTicksFor(schedPtr, ramPtr, from, to, compiled); \
+     } \
+     void runShardWork##name(frameShard * shardPtr, ram * ramPtr, int time) { \
+          runShardWorkFor(shardPtr, ramPtr, time, compiled); \
+     }
+
+TICK_LOOP(FIFO, FIFO)
+TICK_LOOP(LRU, LRU)
+TICK_LOOP(LFU, LFU)
+TICK_LOOP(MFU, MFU)
+TICK_LOOP(RANDOM, RANDOM)
+TICK_LOOP(CLOCK, CLOCK)
+TICK_LOOP(ARC, ARC)
+TICK_LOOP(TWOQ, TWOQ)
+TICK_LOOP(LIRS, LIRS)
+TICK_LOOP(OPT, OPT)
+TICK_LOOP(AnyPolicy, ANY_POLICY)
+
+// indexed by policy, ANY_POLICY last
+tickLoop tickLoops[NUM_POLICIES + 1] = {
+     {runTicksFIFO, runShardWorkFIFO}, {runTicksLRU, runShardWorkLRU}, {runTicksLFU, runShardWorkLFU},
+     {runTicksMFU, runShardWorkMFU}, {runTicksRANDOM, runShardWorkRANDOM}, {runTicksCLOCK, runShardWorkCLOCK},
+     {runTicksARC, runShardWorkARC}, {runTicksTWOQ, runShardWorkTWOQ}, {runTicksLIRS, runShardWorkLIRS},
+     {runTicksOPT, runShardWorkOPT}, {runTicksAnyPolicy, runShardWorkAnyPolicy}
+};
+
+// advances the simulation through the ticks from up to, not including, to, in the copy of the tick loop
+// compiled for the memory's policy; lanes of a shared run each have their own policy and take the copy
+// for any policy
+// the shard threads live only as long as the call, so a trial can fork between calls
+void runTicks(scheduler * schedPtr, ram * ramPtr, int from, int to) {
+     tickLoop * loopPtr = &tickLoops[(ramPtr->genericCore || ramPtr->nextLane) ? ANY_POLICY : ramPtr->desiredPolicy];
+     if (ramPtr->numberOfShards > 1)
+          startShardPool(ramPtr, loopPtr->runShardWork);
+     loopPtr->runTicks(schedPtr, ramPtr, from, to);
+     if (ramPtr->shards)
+          stopShardPool(ramPtr);
+}
+
+// simulates the workload's jobs against memory for the whole run
+void runWorkload(jobSource * sourcePtr, ram * ramPtr) {
+     scheduler sched;
+     initScheduler(&sched, sourcePtr);
+     runTicks(&sched, ramPtr, 0, sourcePtr->trialTicks);
+     freeScheduler(&sched);
+}
+
+// runs one workload under LRU and feeds every reference into the stack distance analyzer
+// the simulated memory only decides the schedule, the analyzer answers for every memory size at once.
+// Its one stack holds the pages of every process, so the curve is that of global LRU
+void runStackDistanceTrial(config * cfg, int workloadNum, stackDistance * stackPtr, arena * arenaPtr) {
+     jobSource source;
+     initJobSource(&source, cfg, workloadNum);
+
+     ram * ramPtr = downloadRAM(cfg->numberOfFrames, arenaPtr);
+     ramPtr->desiredPolicy = LRU;
+     applyMemoryOptions(ramPtr, cfg);
+     ramPtr->stackPtr = stackPtr;
+
+     runWorkload(&source, ramPtr);
+
+     resetArena(arenaPtr);
+}
+
+// simulates every workload under LRU on this thread and records their events into one trace file
+void recordWorkloads(config * cfg) {
+     traceRecorder * recorderPtr = openTraceRecorder(cfg->recordPath, cfg->numberOfFrames);
+     arena workloadArena;
+     arena * arenaPtr = &workloadArena;
+     initArena(arenaPtr);
+     int workloadNum;
+     for (workloadNum = 0; workloadNum < cfg->numberOfWorkloads; ++workloadNum) {
+          jobSource source;
+          initJobSource(&source, cfg, workloadNum);
+
+          ram * ramPtr = downloadRAM(cfg->numberOfFrames, arenaPtr);
+          ramPtr->desiredPolicy = LRU;
+          ramPtr->recorderPtr = recorderPtr;
+
+          recordTraceEvent(recorderPtr, TRACE_BEGIN, 0, workloadNum, 0);
+          runWorkload(&source, ramPtr);
+
+          resetArena(&workloadArena);
+     }
+     printf("Recorded %d workloads, %lld events into %s\n", cfg->numberOfWorkloads,
+          recorderPtr->header.numberOfRecords, cfg->recordPath);
+     closeTraceRecorder(recorderPtr);
+     freeArena(arenaPtr);
+}
+
+typedef struct _mappedTrace {
+    traceHeader * header;      // start of the mapping
+    traceRecord * records;     // records directly following the header
+    size_t length;             // length of the mapping in bytes
+} mappedTrace;
+
+// maps a trace file read-only and checks that it was written by a compatible recorder
+void mapTrace(char * path, mappedTrace * tracePtr) {
+     int fd = open(path, O_RDONLY);
+     struct stat st;
+     if (fd < 0 || fstat(fd, &st) != 0) {
+          printf("ERROR OPENING TRACE FILE %s\n", path);
+          exit(1);
+     }
+     if ((size_t)st.st_size < sizeof(traceHeader)) {
+          printf("ERROR TRACE FILE %s IS TRUNCATED\n", path);
+          exit(1);
+     }
+     tracePtr->length = st.st_size;
+     void * base = mmap(NULL, tracePtr->length, PROT_READ, MAP_PRIVATE, fd, 0);
+     close(fd);
+     if (base == MAP_FAILED) {
+          printf("ERROR MAPPING TRACE FILE %s\n", path);
+          exit(1);
+     }
+     madvise(base, tracePtr->length, MADV_SEQUENTIAL);
+
+     tracePtr->header = base;
+     tracePtr->records = (traceRecord *)((char *)base + sizeof(traceHeader));
+     traceHeader * header = tracePtr->header;
+     if (memcmp(header->magic, TRACE_MAGIC, sizeof(TRACE_MAGIC)) != 0 || header->version != TRACE_VERSION ||
+          header->recordSize != sizeof(traceRecord) || header->numberOfSegments > TRACE_MAX_SEGMENTS ||
+          sizeof(traceHeader) + header->numberOfRecords * sizeof(traceRecord) > tracePtr->length) {
+          printf("ERROR %s IS NOT A VALID TRACE FILE\n", path);
+          exit(1);
+     }
+}
+
+void unmapTrace(mappedTrace * tracePtr) {
+     munmap(tracePtr->header, tracePtr->length);
+}
+
+// returns 1 if a record is a reference of a process, its arrival standing for the reference to page 0
+// references the replay would reject are skipped so every pass agrees on each process' reference count
+int replayedReference(traceRecord * recordPtr, int * pages, int * pageIDPtr) {
+     int value = recordPtr->event & TRACE_VALUE_MASK;
+     int event = recordPtr->event >> TRACE_EVENT_SHIFT;
+     if (recordPtr->pid < 0 || (event != TRACE_ARRIVE && event != TRACE_REFERENCE))
+          return 0;
+     *pageIDPtr = (event == TRACE_ARRIVE) ? 0 : value;
+     return !pages || *pageIDPtr < pages[recordPtr->pid];
+}
+
+// OPT on a replayed trace: the future is the rest of the segment, so the next-use index of every
+// process is read backwards off its records. Returns the number of pids covered, the arrays live in the arena
+int buildReplayNextUse(mappedTrace * tracePtr, int segment, int *** deltasPtr, int ** countsPtr, arena * arenaPtr) {
+     traceRecord * first = &tracePtr->records[tracePtr->header->segmentStart[segment]];
+     traceRecord * last = &tracePtr->records[tracePtr->header->segmentStart[segment + 1]];
+     traceRecord * recordPtr;
+     int pageID;
+     int processSlots = 0;
+     for (recordPtr = first; recordPtr < last; ++recordPtr) {
+          if (replayedReference(recordPtr, NULL, &pageID) && recordPtr->pid >= processSlots)
+               processSlots = recordPtr->pid + 1;
+     }
+
+     int * pages = calloc(processSlots + 1, sizeof(int));
+     int * counts = arenaAlloc(arenaPtr, sizeof(int) * (processSlots + 1));
+     int ** deltas = arenaAlloc(arenaPtr, sizeof(int *) * (processSlots + 1));
+     memset(counts, 0, sizeof(int) * (processSlots + 1));
+     for (recordPtr = first; recordPtr < last; ++recordPtr) {
+          int value = recordPtr->event & TRACE_VALUE_MASK;
+          if ((recordPtr->event >> TRACE_EVENT_SHIFT) == TRACE_ARRIVE && recordPtr->pid >= 0 && value > pages[recordPtr->pid])
+               pages[recordPtr->pid] = value;
+     }
+     for (recordPtr = first; recordPtr < last; ++recordPtr) {
+          if (replayedReference(recordPtr, pages, &pageID))
+               ++counts[recordPtr->pid];
+     }
+
+     // lastSeen holds the index of every page's next reference in its process' string while walking backwards
+     int * offsets = malloc(sizeof(int) * (processSlots + 1));
+     int totalPages = 0;
+     int pid;
+     for (pid = 0; pid < processSlots; ++pid) {
+          offsets[pid] = totalPages;
+          totalPages += pages[pid];
+          deltas[pid] = arenaAlloc(arenaPtr, sizeof(int) * (counts[pid] ? counts[pid] : 1));
+     }
+     int * lastSeen = malloc(sizeof(int) * (totalPages ? totalPages : 1));
+     int * position = malloc(sizeof(int) * (processSlots + 1));
+     int i;
+     for (i = 0; i < totalPages; ++i)
+          lastSeen[i] = -1;
+     memcpy(position, counts, sizeof(int) * (processSlots + 1));
+     for (recordPtr = last - 1; recordPtr >= first; --recordPtr) {
+          if (!replayedReference(recordPtr, pages, &pageID))
+               continue;
+          int * seenPtr = &lastSeen[offsets[recordPtr->pid] + pageID];
+          int index = --position[recordPtr->pid];
+          deltas[recordPtr->pid][index] = (*seenPtr < 0) ? INT_MAX : *seenPtr - index;
+          *seenPtr = index;
+     }
+     free(pages);
+     free(offsets);
+     free(lastSeen);
+     free(position);
+
+     *deltasPtr = deltas;
+     *countsPtr = counts;
+     return processSlots;
+}
+
+// streams one recorded workload through memory under the trial's policy
+// processes run only between their TRACE_ARRIVE and TRACE_EXIT records, their memory is released with the arena
+void runReplayTrial(config * cfg, mappedTrace * tracePtr, int trialNum, arena * arenaPtr) {
+     int segment = trialNum / NUM_POLICIES;
+     trial_statistics[trialNum][0] = 0;
+     trial_statistics[trialNum][1] = 0;
+     trial_statistics[trialNum][2] = 0;
+     memset(&trial_thrashing[trialNum], 0, sizeof(thrashingStats));
+     memset(&trial_prefetch[trialNum], 0, sizeof(prefetchStats));
+     if (segment >= tracePtr->header->numberOfSegments)
+          return;
+
+     ram * ramPtr = downloadRAM(cfg->numberOfFrames, arenaPtr);
+     ramPtr->desiredPolicy = trialNum % NUM_POLICIES;
+     applyMemoryOptions(ramPtr, cfg);
+     // the recording fixes when processes run and reference, so there is nothing for a load controller
+     // to decide and no process can be held up by the disk
+     ramPtr->loadControl = LOAD_NONE;
+     ramPtr->diskLatency = 0;
+
+     int ** futureDeltas = NULL;
+     int * futureCounts = NULL;
+     int futureSlots = 0;
+     if (ramPtr->desiredPolicy == OPT)
+          futureSlots = buildReplayNextUse(tracePtr, segment, &futureDeltas, &futureCounts, arenaPtr);
+
+     int processSlots = 64;
+     process ** running = calloc(processSlots, sizeof(process *));
+
+     long long i;
+     for (i = tracePtr->header->segmentStart[segment]; i < tracePtr->header->segmentStart[segment + 1]; ++i) {
+          traceRecord * recordPtr = &tracePtr->records[i];
+          int value = recordPtr->event & TRACE_VALUE_MASK;
+          int pid = recordPtr->pid;
+          if (pid >= processSlots && (recordPtr->event >> TRACE_EVENT_SHIFT) == TRACE_ARRIVE) {
+               int oldSlots = processSlots;
+               while (pid >= processSlots)
+                    processSlots *= 2;
+               running = realloc(running, sizeof(process *) * processSlots);
+               memset(running + oldSlots, 0, sizeof(process *) * (processSlots - oldSlots));
+          }
+          process * procPtr = (pid < processSlots) ? running[pid] : NULL;
+
+          switch (recordPtr->event >> TRACE_EVENT_SHIFT) {
+               case TRACE_BEGIN:
+                    break;
+               case TRACE_ARRIVE:
+                    procPtr = createProcess(pid, 0, 0, value, cfg->seed ^ (unsigned long long)pid, arenaPtr);
+                    running[pid] = procPtr;
+                    if (pid < futureSlots) {
+                         procPtr->nextUseDelta = futureDeltas[pid];
+                         procPtr->numberOfReferences = futureCounts[pid];
+                    }
+                    startProcess(procPtr, ramPtr, recordPtr->time);
+                    break;
+               case TRACE_REFERENCE:
+                    if (!procPtr || value >= procPtr->numberOfPages) {
+                         printf("ERROR TRACE REFERENCES UNKNOWN PAGE %d OF PROCESS %d\n", value, pid);
+                         exit(1);
+                    }
+                    accessPage(procPtr, &procPtr->pageTable[value], ramPtr, recordPtr->time);
+                    break;
+               case TRACE_EXIT:
+                    if (!procPtr) {
+                         printf("ERROR TRACE STOPS UNKNOWN PROCESS %d\n", pid);
+                         exit(1);
+                    }
+                    stopProcess(procPtr, ramPtr, recordPtr->time);
+                    running[pid] = NULL;
+                    break;
+          }
+     }
+
+     trial_statistics[trialNum][0] = ramPtr->jobsRun;
+     trial_statistics[trialNum][1] = ramPtr->hits;
+     trial_statistics[trialNum][2] = ramPtr->misses;
+     trial_thrashing[trialNum] = ramPtr->thrashing;
+     trial_prefetch[trialNum] = ramPtr->prefetch;
+     free(running);
+     resetArena(arenaPtr);
+}
+
+// runs one workload under every policy at once, all lanes replaying the same reference stream
+// jobs are admitted only when every lane has room, so all policies see the same schedule
+void runSharedTrial(config * cfg, int workloadNum, arena * arenaPtr) {
+     ram * lanes[NUM_POLICIES];
+     int polNum;
+     for (polNum = 0; polNum < NUM_POLICIES; ++polNum) {
+          lanes[polNum] = downloadRAM(cfg->numberOfFrames, arenaPtr);
+          lanes[polNum]->desiredPolicy = polNum;
+          applyMemoryOptions(lanes[polNum], cfg);
+          if (polNum > 0)
+               lanes[polNum - 1]->nextLane = lanes[polNum];
+     }
+     // each admitted job is copied into every lane
+     jobSource source;
+     initJobSource(&source, cfg, workloadNum);
+
+     runWorkload(&source, lanes[0]);
+
+     for (polNum = 0; polNum < NUM_POLICIES; ++polNum) {
+          int trialNum = workloadNum * NUM_POLICIES + polNum;
+          trial_statistics[trialNum][0] = lanes[polNum]->jobsRun;
+          trial_statistics[trialNum][1] = lanes[polNum]->hits;
+          trial_statistics[trialNum][2] = lanes[polNum]->misses;
+          trial_thrashing[trialNum] = lanes[polNum]->thrashing;
+          trial_prefetch[trialNum] = lanes[polNum]->prefetch;
+     }
+     resetArena(arenaPtr);
+}
+
+// runs one workload under one policy, the returned memory holds the counters until the arena is rewound
+ram * simulateWorkload(config * cfg, int workloadNum, policy desiredPolicy, arena * arenaPtr) {
+     jobSource source;
+     initJobSource(&source, cfg, workloadNum);
+
+     ram * ramPtr = downloadRAM(cfg->numberOfFrames, arenaPtr);
+     ramPtr->desiredPolicy = desiredPolicy;
+     applyMemoryOptions(ramPtr, cfg);
+
+     runWorkload(&source, ramPtr);
+     return ramPtr;
+}
+
+// runs one workload under one policy and fills the trial's statistics slot
+void runTrial(config * cfg, int trialNum, arena * arenaPtr) {
+     ram * ramPtr = simulateWorkload(cfg, trialNum / NUM_POLICIES, trialNum % NUM_POLICIES, arenaPtr);
+
+     trial_statistics[trialNum][0] = ramPtr->jobsRun;
+     trial_statistics[trialNum][1] = ramPtr->hits;
+     trial_statistics[trialNum][2] = ramPtr->misses;
+     trial_thrashing[trialNum] = ramPtr->thrashing;
+     trial_prefetch[trialNum] = ramPtr->prefetch;
+
+     resetArena(arenaPtr);
+}
+
+// reaps one finished forked trial, exits if it did not complete
+void waitForForkedTrial() {
+     int status;
+     if (wait(&status) < 0 || !WIFEXITED(status) || WEXITSTATUS(status) != 0) {
+          printf("ERROR FORKED TRIAL FAILED\n");
+          exit(1);
+     }
+}
+
+// runs the workload under FORK_WARMUP_POLICY up to the fork tick, then forks a child per policy that
+// switches to it and runs the rest of the workload. The children share the warm state copy-on-write,
+// so the prefix is simulated once, and their statistics cover only the ticks after the fork
+void runForkedWorkload(config * cfg, int workloadNum, arena * arenaPtr, int * childrenPtr) {
+     jobSource source;
+     initJobSource(&source, cfg, workloadNum);
+     ram * ramPtr = downloadRAM(cfg->numberOfFrames, arenaPtr);
+     ramPtr->desiredPolicy = FORK_WARMUP_POLICY;
+     applyMemoryOptions(ramPtr, cfg);
+     scheduler sched;
+     initScheduler(&sched, &source);
+     int forkTick = cfg->forkSeconds * TICKS_PER_SECOND;
+     // the policy switch after the warm-up reads page metadata the warm-up policy has no use for
+     ramPtr->genericCore = 1;
+     runTicks(&sched, ramPtr, 0, forkTick);
+     ramPtr->genericCore = cfg->genericCore;
+
+     fflush(stdout);
+     int polNum;
+     for (polNum = 0; polNum < NUM_POLICIES; ++polNum) {
+          if (*childrenPtr == cfg->numberOfThreads) {
+               waitForForkedTrial();
+               --*childrenPtr;
+          }
+          pid_t child = fork();
+          if (child < 0) {
+               printf("ERROR FORKING TRIAL\n");
+               exit(1);
+          }
+          if (child == 0) {
+               int trialNum = workloadNum * NUM_POLICIES + polNum;
+               switchPolicy(&sched, ramPtr, polNum);
+               ramPtr->jobsRun = 0;
+               ramPtr->hits = 0;
+               ramPtr->misses = 0;
+               memset(&ramPtr->thrashing, 0, sizeof(thrashingStats));
+               memset(&ramPtr->prefetch, 0, sizeof(prefetchStats));
+               runTicks(&sched, ramPtr, forkTick, source.trialTicks);
+               // the fault rates must count this policy's faults and none of the warm-up's
+               long long windowFaults = 0;
+               int window;
+               for (window = 0; window < THRASHING_WINDOWS; ++window)
+                    windowFaults += ramPtr->thrashing.faultsPerWindow[window];
+               if (windowFaults != ramPtr->misses) {
+                    printf("ERROR FORKED TRIAL %d COUNTED %lld FAULTS IN ITS FAULT RATES BUT MISSED %lld PAGES\n",
+                         trialNum, windowFaults, ramPtr->misses);
+                    fflush(stdout);
+                    _exit(1);
+               }
+               trial_statistics[trialNum][0] = ramPtr->jobsRun;
+               trial_statistics[trialNum][1] = ramPtr->hits;
+               trial_statistics[trialNum][2] = ramPtr->misses;
+               trial_thrashing[trialNum] = ramPtr->thrashing;
+               trial_prefetch[trialNum] = ramPtr->prefetch;
+               _exit(0);
+          }
+          ++*childrenPtr;
+     }
+     freeScheduler(&sched);
+     resetArena(arenaPtr);
+}
+
+// runs every workload forked, at most numberOfThreads trials at a time, the warm-up of the next
+// workload overlapping the children of the previous ones
+void runForkedTrials(config * cfg) {
+     arena workloadArena;
+     initArena(&workloadArena);
+     int children = 0;
+     int workloadNum;
+     for (workloadNum = 0; workloadNum < cfg->numberOfWorkloads; ++workloadNum)
+          runForkedWorkload(cfg, workloadNum, &workloadArena, &children);
+     for (; children > 0; --children)
+          waitForForkedTrial();
+     freeArena(&workloadArena);
+}
+
+double elapsedSeconds(struct timespec * start) {
+     struct timespec now;
+     clock_gettime(CLOCK_MONOTONIC, &now);
+     return (now.tv_sec - start->tv_sec) + (now.tv_nsec - start->tv_nsec) * 1e-9;
+}
+
+// global LRU victim scan over the page structs, reached through every frame's pagePtr
+int scanFramesLRU(ram * ramPtr, int pid) {
+     int best = -1;
+     int bestTime = 0;
+     int i;
+     for (i = 0; i < ramPtr->numberOfFrames; ++i) {
+          memory * memPtr = &ramPtr->frames[i];
+          if (memPtr->busy && memPtr->pagePtr->pid == pid && (best < 0 || memPtr->pagePtr->timeLastReferenced < bestTime)) {
+               best = i;
+               bestTime = memPtr->pagePtr->timeLastReferenced;
+          }
+     }
+     return best;
+}
+
+// fills growing memories with pages of 64-page processes scattered over the frames and
+// times the LRU victim scan of random processes on both metadata layouts
+void benchmarkFrameLayout(config * cfg) {
+     int pagesPerProcess = 64;
+     printf("scan kernel: %s\n", frameScanName);
+     printf("%10s %10s %16s %16s %8s\n", "frames", "faults", "struct faults/s", "array faults/s", "speedup");
+     int numberOfFrames;
+     for (numberOfFrames = 1 << 10; numberOfFrames <= 1 << 20; numberOfFrames <<= 2) {
+          arena benchArena;
+          initArena(&benchArena);
+          rng benchStream;
+          rngSeed(&benchStream, cfg->seed, numberOfFrames);
+
+          ram * ramPtr = downloadRAM(numberOfFrames, &benchArena);
+          ramPtr->desiredPolicy = FIFO;
+          ramPtr->victimScan = 1;
+          int numberOfProcesses = numberOfFrames / pagesPerProcess;
+          process ** procs = arenaAlloc(&benchArena, sizeof(process *) * numberOfProcesses);
+          page ** order = arenaAlloc(&benchArena, sizeof(page *) * numberOfFrames);
+          int i;
+          for (i = 0; i < numberOfProcesses; ++i) {
+               procs[i] = createProcess(i, 0, 0, pagesPerProcess, rngNext(&benchStream), &benchArena);
+               int j;
+               for (j = 0; j < pagesPerProcess; ++j)
+                    order[i * pagesPerProcess + j] = &procs[i]->pageTable[j];
+          }
+          // page in in shuffled order so neighbouring frames hold unrelated page structs
+          for (i = numberOfFrames - 1; i > 0; --i) {
+               int j = rngBelow(&benchStream, i + 1);
+               page * tempPtr = order[i];
+               order[i] = order[j];
+               order[j] = tempPtr;
+          }
+          for (i = 0; i < numberOfFrames; ++i) {
+               page * pagePtr = order[i];
+               pageIn(procs[pagePtr->pid], pagePtr, ramPtr, i);
+               referencePage(procs[pagePtr->pid], pagePtr, ramPtr, rngBelow(&benchStream, numberOfFrames));
+          }
+
+          // every fault stamps its victim as just referenced so the next scan of that process finds a new one
+          int faults = (1 << 26) / numberOfFrames;
+          int * pids = arenaAlloc(&benchArena, sizeof(int) * faults);
+          int * victims = arenaAlloc(&benchArena, sizeof(int) * faults);
+          for (i = 0; i < faults; ++i)
+               pids[i] = rngBelow(&benchStream, numberOfProcesses);
+
+          struct timespec start;
+          clock_gettime(CLOCK_MONOTONIC, &start);
+          for (i = 0; i < faults; ++i) {
+               victims[i] = scanFramesLRU(ramPtr, pids[i]);
+               ramPtr->frames[victims[i]].pagePtr->timeLastReferenced = numberOfFrames + i;
+          }
+          double structSeconds = elapsedSeconds(&start);
+
+          clock_gettime(CLOCK_MONOTONIC, &start);
+          for (i = 0; i < faults; ++i) {
+               int memID = frameArgMin(ramPtr->meta.lastReferenced, ramPtr->meta.owner, numberOfFrames, pids[i]);
+               ramPtr->meta.lastReferenced[memID] = numberOfFrames + i;
+               if (memID != victims[i]) {
+                    printf("ERROR LAYOUTS DISAGREE ON VICTIM OF FAULT %d\n", i);
+                    exit(1);
+               }
+          }
+          double arraySeconds = elapsedSeconds(&start);
+
+          printf("%10d %10d %16.0f %16.0f %7.2fx\n", numberOfFrames, faults,
+               faults / structSeconds, faults / arraySeconds, structSeconds / arraySeconds);
+          freeArena(&benchArena);
+     }
+}
+
+// a workload size the benchmark suite times every policy at
+typedef struct _benchScale {
+    int numberOfFrames;        // memory size
+    int pagesPerProcess;       // size of every process
+    int numberOfJobs;          // jobs of the workload
+    int trialSeconds;          // length of the run
+} benchScale;
+
+// a job references at most 50 pages whatever its size, so the arrival rate grows with the frames to keep
+// memory full and faults replacing; every scale makes about a million references
+benchScale benchScales[] = {
+     {100, 16, 32000, 4000},
+     {1000, 64, 32000, 960},
+     {10000, 256, 32000, 96},
+};
+
+int compareDoubles(const void * a, const void * b) {
+     double x = *(const double *)a;
+     double y = *(const double *)b;
+     return (x > y) - (x < y);
+}
+
+// runs one benchmark case and checks it made the same references and faults as its other runs
+ram * runBenchmarkCase(config * benchCfg, policy desiredPolicy, arena * arenaPtr, long long * referencesPtr,
+     long long * faultsPtr) {
+     ram * ramPtr = simulateWorkload(benchCfg, 0, desiredPolicy, arenaPtr);
+     if (*referencesPtr >= 0 && (ramPtr->hits + ramPtr->misses != *referencesPtr || ramPtr->misses != *faultsPtr)) {
+          printf("ERROR BENCHMARK RUNS OF %s DISAGREE\n", policyNames[desiredPolicy]);
+          exit(1);
+     }
+     *referencesPtr = ramPtr->hits + ramPtr->misses;
+     *faultsPtr = ramPtr->misses;
+     return ramPtr;
+}
+
+// times the whole simulator on every policy at every benchmark scale, single threaded
+// the reference and fault counts are exact and the median of the timed runs damps the noise, so the
+// table can be diffed between builds. The share of each phase and the cost of a fault come from one
+// more run with the phase clock on, since reading the clock around every phase slows the run down.
+// Every case is also timed in the tick loop compiled for any policy, and gain is how much slower that is
+void benchmarkSuite(config * cfg) {
+     printf("%d warm-up and %d timed runs per case, median shown\n", BENCH_WARMUP_RUNS, BENCH_TIMED_RUNS);
+     arena benchArena;
+     initArena(&benchArena);
+     int scaleNum;
+     for (scaleNum = 0; scaleNum < (int)(sizeof(benchScales) / sizeof(benchScales[0])); ++scaleNum) {
+          benchScale * scalePtr = &benchScales[scaleNum];
+          config benchCfg = *cfg;
+          benchCfg.numberOfFrames = scalePtr->numberOfFrames;
+          benchCfg.numberOfJobs = scalePtr->numberOfJobs;
+          benchCfg.trialSeconds = scalePtr->trialSeconds;
+          benchCfg.numberOfProcessSizes = 1;
+          benchCfg.processSizes[0] = scalePtr->pagesPerProcess;
+
+          printf("\nframes %d, pages per process %d, jobs %d, seconds %d\n", scalePtr->numberOfFrames,
+               scalePtr->pagesPerProcess, scalePtr->numberOfJobs, scalePtr->trialSeconds);
+          printf("%-7s %11s %10s %9s %8s %8s %6s %9s %7s", "policy", "references", "faults", "Mrefs/s", "ns/ref",
+               "generic", "gain", "ns/fault", "spread");
+          int phase;
+          for (phase = 0; phase < NUM_PHASES; ++phase)
+               printf(" %5s%%", phaseNames[phase]);
+          printf("\n");
+
+          int polNum;
+          for (polNum = 0; polNum < NUM_POLICIES; ++polNum) {
+               long long references = -1;
+               long long faults = -1;
+               double seconds[BENCH_TIMED_RUNS];
+               double genericSeconds[BENCH_TIMED_RUNS];
+               int run;
+               // the generic loop runs right after each specialized run so drift hits both alike,
+               // and runBenchmarkCase checks that both count the same references and faults
+               for (run = 0; run < BENCH_WARMUP_RUNS + BENCH_TIMED_RUNS; ++run) {
+                    int generic;
+                    for (generic = 0; generic < 2; ++generic) {
+                         benchCfg.genericCore = generic;
+                         long long start = monotonicNanoseconds();
+                         runBenchmarkCase(&benchCfg, polNum, &benchArena, &references, &faults);
+                         long long elapsed = monotonicNanoseconds() - start;
+                         resetArena(&benchArena);
+                         if (run >= BENCH_WARMUP_RUNS)
+                              (generic ? genericSeconds : seconds)[run - BENCH_WARMUP_RUNS] = elapsed * 1e-9;
+                    }
+               }
+               benchCfg.genericCore = cfg->genericCore;
+
+               phaseClock clock;
+               memset(&clock, 0, sizeof(clock));
+               clock.since = monotonicNanoseconds();
+               activeClock = &clock;
+               runBenchmarkCase(&benchCfg, polNum, &benchArena, &references, &faults);
+               chargePhase(&clock);
+               activeClock = NULL;
+               resetArena(&benchArena);
+               long long phasedTotal = 0;
+               for (phase = 0; phase < NUM_PHASES; ++phase)
+                    phasedTotal += clock.nanoseconds[phase];
+
+               qsort(seconds, BENCH_TIMED_RUNS, sizeof(double), compareDoubles);
+               qsort(genericSeconds, BENCH_TIMED_RUNS, sizeof(double), compareDoubles);
+               double median = seconds[BENCH_TIMED_RUNS / 2];
+               double genericMedian = genericSeconds[BENCH_TIMED_RUNS / 2];
+               printf("%-7s %11lld %10lld %9.2f %8.1f %8.1f %5.1f%% %9.1f %6.1f%%", policyNames[polNum], references,
+                    faults, references / median * 1e-6, median * 1e9 / references,
+                    genericMedian * 1e9 / references, (genericMedian / median - 1) * 100,
+                    faults ? (double)(clock.nanoseconds[PHASE_REPLACE] + clock.nanoseconds[PHASE_PAGING]) / faults : 0.0,
+                    (seconds[BENCH_TIMED_RUNS - 1] - seconds[0]) / median * 100);
+               for (phase = 0; phase < NUM_PHASES; ++phase)
+                    printf(" %5.1f%%", phasedTotal ? clock.nanoseconds[phase] * 100.0 / phasedTotal : 0.0);
+               printf("\n");
+          }
+     }
+     freeArena(&benchArena);
+}
+
+// one set of process sizes on the sizes axis of a sweep
+typedef struct _sizeSet {
+    int numberOfProcessSizes;              // number of entries in processSizes
+    int processSizes[MAX_PROCESS_SIZES];   // process sizes in pages
+} sizeSet;
+
+// grid of configurations a parameter sweep runs, every point once per workload
+// points are numbered with the policy varying fastest, then the sizes, the locality and the frames
+typedef struct _sweep {
+    config * cfg;              // configuration the axes override
+    int * frames;              // memory sizes of the grid
+    int numberOfFrameCounts;   // number of entries in frames
+    int * localities;          // locality percentages of the grid
+    int numberOfLocalities;    // number of entries in localities
+    sizeSet * sizeSets;        // process size sets of the grid
+    int numberOfSizeSets;      // number of entries in sizeSets
+    int * policies;            // policies of the grid
+    int numberOfPolicies;      // number of entries in policies
+    int numberOfPoints;        // product of the axis lengths
+    long long (* trialResults)[3]; // jobs run, hits and misses of every trial, numberOfWorkloads per point
+    atomic_int * trialsLeft;   // trials of every point that have not finished
+    char * finished;           // 1 once all trials of a point are done, or its row was found on resume
+    char * written;            // 1 once a point's row is in the results
+    int nextRow;               // first point whose row is not out yet, rows go out in point order
+    int pointsDone;            // rows written, including those found on resume
+    FILE * results;            // sink of the result rows
+    pthread_mutex_t lock;      // guards finished, written, nextRow, pointsDone and results
+} sweep;
+
+// appends a value to one of a sweep's axes
+int * appendAxisValue(int * values, int * count, int value) {
+     values = realloc(values, sizeof(int) * (*count + 1));
+     values[(*count)++] = value;
+     return values;
+}
+
+// looks up a policy by the name the statistics print it under
+int parsePolicyName(char * name) {
+     int polNum;
+     for (polNum = 0; polNum < NUM_POLICIES; ++polNum) {
+          if (strcmp(name, policyNames[polNum]) == 0)
+               return polNum;
+     }
+     printf("ERROR UNKNOWN POLICY %s\n", name);
+     exit(1);
+}
+
+// reads the grid of a sweep from its spec file, one axis per line followed by its values:
+//   frames 50 100 200
+//   locality 50 70 90
+//   sizes 5,11,17,31 8,16
+//   policy LRU OPT
+// an axis left out keeps the value of the command line, or every policy, and # starts a comment
+void loadSweepSpec(sweep * sweepPtr, config * cfg) {
+     FILE * specFile = fopen(cfg->sweepPath, "r");
+     if (!specFile) {
+          printf("ERROR OPENING SWEEP SPEC %s\n", cfg->sweepPath);
+          exit(1);
+     }
+     memset(sweepPtr, 0, sizeof(sweep));
+     sweepPtr->cfg = cfg;
+
+     char line[4096];
+     while (fgets(line, sizeof(line), specFile)) {
+          if (!strchr(line, '\n') && !feof(specFile)) {
+               printf("ERROR SWEEP SPEC LINE LONGER THAN %d CHARACTERS\n", (int)sizeof(line) - 2);
+               exit(1);
+          }
+          char * comment = strchr(line, '#');
+          if (comment)
+               *comment = '\0';
+          char * axis = strtok(line, " \t\r\n");
+          if (!axis)
+               continue;
+          int * countPtr;
+          if (strcmp(axis, "frames") == 0)
+               countPtr = &sweepPtr->numberOfFrameCounts;
+          else if (strcmp(axis, "locality") == 0)
+               countPtr = &sweepPtr->numberOfLocalities;
+          else if (strcmp(axis, "sizes") == 0 && cfg->workloadsPtr) {
+               printf("ERROR A SWEEP OVER SAVED WORKLOADS CANNOT VARY THEIR SIZES\n");
+               exit(1);
+          }
+          else if (strcmp(axis, "sizes") == 0)
+               countPtr = &sweepPtr->numberOfSizeSets;
+          else if (strcmp(axis, "policy") == 0)
+               countPtr = &sweepPtr->numberOfPolicies;
+          else {
+               printf("ERROR UNKNOWN SWEEP AXIS %s\n", axis);
+               exit(1);
+          }
+          if (*countPtr > 0) {
+               printf("ERROR SWEEP AXIS %s GIVEN TWICE\n", axis);
+               exit(1);
+          }
+
+          char * value;
+          while ((value = strtok(NULL, " \t\r\n"))) {
+               if (countPtr == &sweepPtr->numberOfFrameCounts)
+                    sweepPtr->frames = appendAxisValue(sweepPtr->frames, countPtr, parsePositiveInt(value, "frames"));
+               else if (countPtr == &sweepPtr->numberOfLocalities)
+                    sweepPtr->localities = appendAxisValue(sweepPtr->localities, countPtr, parseLocality(value));
+               else if (countPtr == &sweepPtr->numberOfPolicies)
+                    sweepPtr->policies = appendAxisValue(sweepPtr->policies, countPtr, parsePolicyName(value));
+               else {
+                    config sizesCfg;
+                    parseProcessSizes(value, &sizesCfg);
+                    sweepPtr->sizeSets = realloc(sweepPtr->sizeSets, sizeof(sizeSet) * (*countPtr + 1));
+                    sizeSet * setPtr = &sweepPtr->sizeSets[(*countPtr)++];
+                    setPtr->numberOfProcessSizes = sizesCfg.numberOfProcessSizes;
+                    memcpy(setPtr->processSizes, sizesCfg.processSizes, sizeof(setPtr->processSizes));
+               }
+          }
+          if (*countPtr == 0) {
+               printf("ERROR SWEEP AXIS %s HAS NO VALUES\n", axis);
+               exit(1);
+          }
+     }
+     fclose(specFile);
+
+     if (sweepPtr->numberOfFrameCounts == 0)
+          sweepPtr->frames = appendAxisValue(NULL, &sweepPtr->numberOfFrameCounts, cfg->numberOfFrames);
+     if (sweepPtr->numberOfLocalities == 0)
+          sweepPtr->localities = appendAxisValue(NULL, &sweepPtr->numberOfLocalities, cfg->localityPercent);
+     if (sweepPtr->numberOfSizeSets == 0) {
+          sweepPtr->sizeSets = malloc(sizeof(sizeSet));
+          sweepPtr->sizeSets->numberOfProcessSizes = cfg->numberOfProcessSizes;
+          memcpy(sweepPtr->sizeSets->processSizes, cfg->processSizes, sizeof(cfg->processSizes));
+          sweepPtr->numberOfSizeSets = 1;
+     }
+     if (sweepPtr->numberOfPolicies == 0) {
+          int polNum;
+          for (polNum = 0; polNum < NUM_POLICIES; ++polNum)
+               sweepPtr->policies = appendAxisValue(sweepPtr->policies, &sweepPtr->numberOfPolicies, polNum);
+     }
+
+     long long points = (long long)sweepPtr->numberOfFrameCounts * sweepPtr->numberOfLocalities
+          * sweepPtr->numberOfSizeSets * sweepPtr->numberOfPolicies;
+     if (points * cfg->numberOfWorkloads > INT_MAX) {
+          printf("ERROR SWEEP OF %lld POINTS IS TOO LARGE\n", points);
+          exit(1);
+     }
+     sweepPtr->numberOfPoints = (int)points;
+}
+
+// fills in the configuration of one point of the grid and returns its policy
+policy sweepPointConfig(sweep * sweepPtr, int point, config * pointCfg) {
+     *pointCfg = *sweepPtr->cfg;
+     policy desiredPolicy = sweepPtr->policies[point % sweepPtr->numberOfPolicies];
+     point /= sweepPtr->numberOfPolicies;
+     sizeSet * setPtr = &sweepPtr->sizeSets[point % sweepPtr->numberOfSizeSets];
+     pointCfg->numberOfProcessSizes = setPtr->numberOfProcessSizes;
+     memcpy(pointCfg->processSizes, setPtr->processSizes, sizeof(setPtr->processSizes));
+     point /= sweepPtr->numberOfSizeSets;
+     pointCfg->localityPercent = sweepPtr->localities[point % sweepPtr->numberOfLocalities];
+     point /= sweepPtr->numberOfLocalities;
+     pointCfg->numberOfFrames = sweepPtr->frames[point];
+     return desiredPolicy;
+}
+
+// writes the columns of a result row that identify the point, the rest of the row follows them
+// a resumed sweep matches these against the rows it finds to tell which points are done
+void formatPointKey(char * buffer, size_t size, resultsFormat format, int point, config * pointCfg,
+     policy desiredPolicy) {
+     int length;
+     if (format == RESULTS_CSV)
+          length = snprintf(buffer, size, "%d,%d,%d,\"", point, pointCfg->numberOfFrames, pointCfg->localityPercent);
+     else
+          length = snprintf(buffer, size, "{\"point\":%d,\"frames\":%d,\"locality\":%d,\"sizes\":[",
+               point, pointCfg->numberOfFrames, pointCfg->localityPercent);
+     int i;
+     for (i = 0; i < pointCfg->numberOfProcessSizes; ++i)
+          length += snprintf(buffer + length, size - length, i ? ",%d" : "%d", pointCfg->processSizes[i]);
+     if (format == RESULTS_CSV)
+          snprintf(buffer + length, size - length, "\",%s", policyNames[desiredPolicy]);
+     else
+          snprintf(buffer + length, size - length, "],\"policy\":\"%s\"", policyNames[desiredPolicy]);
+}
+
+// writes the header line of the csv results
+void writeResultsHeader(FILE * out, resultsFormat format) {
+     if (format == RESULTS_CSV)
+          fprintf(out, "point,frames,locality,sizes,policy,trials,jobs_run,hits,misses,hit_miss_ratio,"
+               "hit_miss_ratio_stddev\n");
+}
+
+// writes the row of one point: its parameters, then the average jobs run, the total hits and misses,
+// the hit/miss ratio of the totals and the standard deviation of the ratio across the trials
+void writeResultRow(FILE * out, resultsFormat format, int point, config * pointCfg, policy desiredPolicy,
+     long long (* stats)[3], int trials) {
+     char key[2048];
+     formatPointKey(key, sizeof(key), format, point, pointCfg, desiredPolicy);
+     long long jobs = 0;
+     long long hits = 0;
+     long long misses = 0;
+     double ratioSum = 0.0;
+     double ratioSquares = 0.0;
+     int trialNum;
+     for (trialNum = 0; trialNum < trials; ++trialNum) {
+          double ratio = (double)stats[trialNum][1] / stats[trialNum][2];
+          jobs += stats[trialNum][0];
+          hits += stats[trialNum][1];
+          misses += stats[trialNum][2];
+          ratioSum += ratio;
+          ratioSquares += ratio * ratio;
+     }
+     double mean = ratioSum / trials;
+     double variance = trials > 1 ? (ratioSquares - trials * mean * mean) / (trials - 1) : 0.0;
+     double deviation = variance > 0.0 ? sqrt(variance) : 0.0;
+     if (format == RESULTS_CSV)
+          fprintf(out, "%s,%d,%.2f,%lld,%lld,%f,%f\n", key, trials, (double)jobs / trials, hits, misses,
+               (double)hits / misses, deviation);
+     else
+          fprintf(out, "%s,\"trials\":%d,\"jobs_run\":%.2f,\"hits\":%lld,\"misses\":%lld,\"hit_miss_ratio\":%f,"
+               "\"hit_miss_ratio_stddev\":%f}\n", key, trials, (double)jobs / trials, hits, misses,
+               (double)hits / misses, deviation);
+}
+
+// opens the results of a sweep, with no results file the rows go to standard output
+// an existing file is taken to be an interrupted run of the same sweep: the points it holds rows for are
+// skipped, a row torn by the interruption is cut off and the new rows are appended
+void openSweepResults(sweep * sweepPtr) {
+     config * cfg = sweepPtr->cfg;
+     if (!cfg->resultsPath) {
+          sweepPtr->results = stdout;
+          writeResultsHeader(stdout, cfg->resultsFormat);
+          return;
+     }
+     FILE * results = fopen(cfg->resultsPath, "r+");
+     if (!results)
+          results = fopen(cfg->resultsPath, "w+");
+     if (!results) {
+          printf("ERROR OPENING RESULTS FILE %s\n", cfg->resultsPath);
+          exit(1);
+     }
+
+     char * line = NULL;
+     size_t capacity = 0;
+     ssize_t length;
+     long completeLength = 0;   // bytes up to the end of the last complete row
+     int headerSeen = 0;
+     while ((length = getline(&line, &capacity, results)) > 0 && line[length - 1] == '\n') {
+          completeLength += length;
+          if (cfg->resultsFormat == RESULTS_CSV && !headerSeen && strncmp(line, "point,", 6) == 0) {
+               headerSeen = 1;
+               continue;
+          }
+          int point = -1;
+          if (cfg->resultsFormat == RESULTS_CSV)
+               sscanf(line, "%d,", &point);
+          else
+               sscanf(line, "{\"point\":%d,", &point);
+          char key[2048];
+          if (point >= 0 && point < sweepPtr->numberOfPoints) {
+               config pointCfg;
+               policy desiredPolicy = sweepPointConfig(sweepPtr, point, &pointCfg);
+               formatPointKey(key, sizeof(key), cfg->resultsFormat, point, &pointCfg, desiredPolicy);
+          }
+          if (point < 0 || point >= sweepPtr->numberOfPoints || strncmp(line, key, strlen(key)) != 0
+               || line[strlen(key)] != ',') {
+               printf("ERROR RESULTS FILE %s WAS WRITTEN BY A DIFFERENT SWEEP\n", cfg->resultsPath);
+               exit(1);
+          }
+          if (!sweepPtr->written[point]) {
+               sweepPtr->written[point] = 1;
+               sweepPtr->finished[point] = 1;
+               atomic_store(&sweepPtr->trialsLeft[point], 0);
+               sweepPtr->pointsDone += 1;
+          }
+     }
+     free(line);
 
-     printVisualDivider();
+     fflush(results);
+     if (ftruncate(fileno(results), completeLength) != 0) {
+          printf("ERROR TRUNCATING RESULTS FILE %s\n", cfg->resultsPath);
+          exit(1);
+     }
+     fseek(results, completeLength, SEEK_SET);
+     if (completeLength == 0)
+          writeResultsHeader(results, cfg->resultsFormat);
+     else if (cfg->resultsFormat == RESULTS_CSV && !headerSeen) {
+          printf("ERROR RESULTS FILE %s WAS WRITTEN BY A DIFFERENT SWEEP\n", cfg->resultsPath);
+          exit(1);
+     }
+     fflush(results);
+     sweepPtr->results = results;
+     if (sweepPtr->pointsDone > 0)
+          printf("Resuming sweep: %d of %d points already done\n", sweepPtr->pointsDone, sweepPtr->numberOfPoints);
+}
+
+// runs one trial of a sweep point, the thread finishing a point's last trial writes every row now due
+void runSweepTrial(sweep * sweepPtr, int unit, arena * arenaPtr) {
+     int workloads = sweepPtr->cfg->numberOfWorkloads;
+     int point = unit / workloads;
+     // a row found on resume is written before any worker starts and never changes afterwards
+     if (sweepPtr->written[point])
+          return;
+
+     config pointCfg;
+     policy desiredPolicy = sweepPointConfig(sweepPtr, point, &pointCfg);
+     ram * ramPtr = simulateWorkload(&pointCfg, unit % workloads, desiredPolicy, arenaPtr);
+     sweepPtr->trialResults[unit][0] = ramPtr->jobsRun;
+     sweepPtr->trialResults[unit][1] = ramPtr->hits;
+     sweepPtr->trialResults[unit][2] = ramPtr->misses;
+     resetArena(arenaPtr);
+     if (atomic_fetch_sub(&sweepPtr->trialsLeft[point], 1) != 1)
+          return;
+
+     pthread_mutex_lock(&sweepPtr->lock);
+     sweepPtr->finished[point] = 1;
+     while (sweepPtr->nextRow < sweepPtr->numberOfPoints && sweepPtr->finished[sweepPtr->nextRow]) {
+          int row = sweepPtr->nextRow++;
+          if (sweepPtr->written[row])
+               continue;
+          desiredPolicy = sweepPointConfig(sweepPtr, row, &pointCfg);
+          writeResultRow(sweepPtr->results, sweepPtr->cfg->resultsFormat, row, &pointCfg, desiredPolicy,
+               &sweepPtr->trialResults[row * workloads], workloads);
+          sweepPtr->written[row] = 1;
+          sweepPtr->pointsDone += 1;
+          if (sweepPtr->results != stdout)
+               printf("Swept %d of %d points\n", sweepPtr->pointsDone, sweepPtr->numberOfPoints);
+     }
+     fflush(sweepPtr->results);
+     pthread_mutex_unlock(&sweepPtr->lock);
+}
+
+// the number of trials, one per workload and policy
+int numberOfTrials(config * cfg) {
+     return cfg->numberOfWorkloads * NUM_POLICIES;
+}
+
+// sizes the per-trial result tables for the configured number of workloads
+// forked trials write their results straight into tables mapped shared with the parent
+void allocateTrialResults(config * cfg) {
+     size_t sizes[3] = {sizeof(*trial_statistics), sizeof(thrashingStats), sizeof(prefetchStats)};
+     void ** tables[3] = {(void **)&trial_statistics, (void **)&trial_thrashing, (void **)&trial_prefetch};
+     int i;
+     for (i = 0; i < 3; ++i) {
+          if (cfg->forkSeconds < 0)
+               *tables[i] = calloc(numberOfTrials(cfg), sizes[i]);
+          else if ((*tables[i] = mmap(NULL, numberOfTrials(cfg) * sizes[i], PROT_READ | PROT_WRITE,
+               MAP_SHARED | MAP_ANONYMOUS, -1, 0)) == MAP_FAILED) {
+               printf("ERROR MAPPING RESULT TABLES\n");
+               exit(1);
+          }
+     }
+}
+
+typedef struct _trialRunner {
+    config * cfg;                      // configuration shared read-only by all workers
+    atomic_int nextTrial;              // next trial number to hand out
+    char * traces[NUM_POLICIES];       // binary event log of the first trial of every policy, NULL if untraced
+    size_t traceLengths[NUM_POLICIES]; // length of each event log
+    stackDistance ** stacks;           // per-workload analyzers in miss ratio curve mode
+    mappedTrace trace;                 // trace shared read-only by all workers in replay mode
+    sweep * sweepPtr;                  // grid every worker claims trials of in sweep mode, NULL otherwise
+} trialRunner;
+
+// worker loop: claims trials until none are left
+// in sweep mode a claim is one workload of one grid point
+// the first trial of every policy logs its events into a private buffer that main emits later in order
+// in shared mode a claim covers a whole workload and nothing is traced since the lanes interleave
+void * trialWorker(void * arg) {
+     trialRunner * runner = arg;
+     arena workloadArena;      // holds the objects of one workload at a time, rewound after each
+     initArena(&workloadArena);
+     activeLog = NULL;
+     int trialNum;
+     int workloadNum;
+     if (runner->sweepPtr) {
+          int units = runner->sweepPtr->numberOfPoints * runner->cfg->numberOfWorkloads;
+          while ((trialNum = atomic_fetch_add(&runner->nextTrial, 1)) < units)
+               runSweepTrial(runner->sweepPtr, trialNum, &workloadArena);
+     }
+     else if (runner->cfg->replayPath) {
+          while ((trialNum = atomic_fetch_add(&runner->nextTrial, 1)) < numberOfTrials(runner->cfg))
+               runReplayTrial(runner->cfg, &runner->trace, trialNum, &workloadArena);
+     }
+     else if (runner->cfg->mrcFrames > 0) {
+          while ((workloadNum = atomic_fetch_add(&runner->nextTrial, 1)) < runner->cfg->numberOfWorkloads)
+               runStackDistanceTrial(runner->cfg, workloadNum, runner->stacks[workloadNum], &workloadArena);
+     }
+     else if (runner->cfg->sharedReferences) {
+          while ((workloadNum = atomic_fetch_add(&runner->nextTrial, 1)) < runner->cfg->numberOfWorkloads)
+               runSharedTrial(runner->cfg, workloadNum, &workloadArena);
+     }
+     else {
+          metricsRecorder * recorderPtr = NULL;
+          if (runner->cfg->metricsSinkPtr) {
+               recorderPtr = malloc(sizeof(metricsRecorder));
+               recorderPtr->sinkPtr = runner->cfg->metricsSinkPtr;
+               recorderPtr->bufferedRecords = 0;
+          }
+          while ((trialNum = atomic_fetch_add(&runner->nextTrial, 1)) < numberOfTrials(runner->cfg)) {
+               if (recorderPtr) {
+                    recorderPtr->trial = trialNum;
+                    recorderPtr->faultsCounted = 0;
+                    recorderPtr->queuedJobs = 0;
+                    recorderPtr->arrivalsStarted = 0;
+                    activeMetrics = recorderPtr;
+               }
+               eventLog log;
+               FILE * sink = NULL;
+               // the shard threads of a trial have no event log of their own
+               if (trialNum < NUM_POLICIES && runner->cfg->logVerbosity != LOG_OFF && runner->cfg->numberOfShards <= 1) {
+                    sink = open_memstream(&runner->traces[trialNum], &runner->traceLengths[trialNum]);
+                    initEventLog(&log, runner->cfg, sink);
+                    activeLog = &log;
+                    int trialPolicy = trialNum % NUM_POLICIES;
+                    logEventRecord(LOG_TRIAL, 0, trialNum, &trialPolicy, 1);
+               }
+
+               runTrial(runner->cfg, trialNum, &workloadArena);
+
+               if (activeLog) {
+                    closeEventLog(activeLog);
+                    fclose(sink);
+                    activeLog = NULL;
+               }
+          }
+          if (recorderPtr) {
+               flushMetrics(recorderPtr);
+               free(recorderPtr);
+               activeMetrics = NULL;
+          }
+     }
+     freeArena(&workloadArena);
+     return NULL;
+}
+
+// runs every trial on a pool of worker threads
+void runTrials(trialRunner * runner) {
+     int numberOfThreads = runner->cfg->numberOfThreads;
+     int claims = runner->sweepPtr ? runner->sweepPtr->numberOfPoints * runner->cfg->numberOfWorkloads
+          : numberOfTrials(runner->cfg);
+     if (numberOfThreads > claims)
+          numberOfThreads = claims;
+
+     pthread_t * workers = malloc(sizeof(pthread_t) * numberOfThreads);
+     atomic_init(&runner->nextTrial, 0);
+
+     int i;
+     for (i = 0; i < numberOfThreads; ++i) {
+          if (pthread_create(&workers[i], NULL, trialWorker, runner) != 0) {
+               printf("ERROR CREATING WORKER THREAD\n");
+               exit(1);
+          }
+     }
+     for (i = 0; i < numberOfThreads; ++i)
+          pthread_join(workers[i], NULL);
+
+     free(workers);
+}
+
+// runs every point of the sweep grid on the worker pool and writes a row per point as it completes
+void runSweep(trialRunner * runner) {
+     sweep sweepState;
+     loadSweepSpec(&sweepState, runner->cfg);
+     int units = sweepState.numberOfPoints * runner->cfg->numberOfWorkloads;
+     sweepState.trialResults = calloc(units, sizeof(*sweepState.trialResults));
+     sweepState.trialsLeft = malloc(sizeof(atomic_int) * sweepState.numberOfPoints);
+     sweepState.finished = calloc(sweepState.numberOfPoints, 1);
+     sweepState.written = calloc(sweepState.numberOfPoints, 1);
+     int point;
+     for (point = 0; point < sweepState.numberOfPoints; ++point)
+          atomic_init(&sweepState.trialsLeft[point], runner->cfg->numberOfWorkloads);
+     pthread_mutex_init(&sweepState.lock, NULL);
+     openSweepResults(&sweepState);
+
+     runner->sweepPtr = &sweepState;
+     runTrials(runner);
+     runner->sweepPtr = NULL;
+
+     if (sweepState.results != stdout)
+          fclose(sweepState.results);
+     pthread_mutex_destroy(&sweepState.lock);
+     free(sweepState.trialResults);
+     free(sweepState.trialsLeft);
+     free(sweepState.finished);
+     free(sweepState.written);
+     free(sweepState.frames);
+     free(sweepState.localities);
+     free(sweepState.sizeSets);
+     free(sweepState.policies);
+}
+
+// writes the statistics of a single configuration as csv or json rows, one point per policy
+void writeResults(config * cfg) {
+     FILE * out = stdout;
+     if (cfg->resultsPath && !(out = fopen(cfg->resultsPath, "w"))) {
+          printf("ERROR OPENING RESULTS FILE %s\n", cfg->resultsPath);
+          exit(1);
+     }
+     writeResultsHeader(out, cfg->resultsFormat);
+     long long (* stats)[3] = malloc(sizeof(*stats) * cfg->numberOfWorkloads);
+     int polNum;
+     for (polNum = 0; polNum < NUM_POLICIES; ++polNum) {
+          int workloadNum;
+          for (workloadNum = 0; workloadNum < cfg->numberOfWorkloads; ++workloadNum)
+               memcpy(stats[workloadNum], trial_statistics[workloadNum * NUM_POLICIES + polNum], sizeof(*stats));
+          writeResultRow(out, cfg->resultsFormat, polNum, cfg, polNum, stats, cfg->numberOfWorkloads);
+     }
+     free(stats);
+     if (out != stdout)
+          fclose(out);
+}
+
+// merges the per-workload stack distances and prints the global LRU miss ratio for every memory size
+void printMissRatioCurve(trialRunner * runner) {
+     int maxFrames = runner->cfg->mrcFrames;
+     long long * distanceCounts = calloc(maxFrames + 1, sizeof(long long));
+     long long totalReferences = 0;
+     long long coldReferences = 0;
+
+     int workloadNum;
+     for (workloadNum = 0; workloadNum < runner->cfg->numberOfWorkloads; ++workloadNum) {
+          stackDistance * stackPtr = runner->stacks[workloadNum];
+          int d;
+          for (d = 1; d <= maxFrames; ++d) {
+               distanceCounts[d] += stackPtr->distanceCounts[d];
+               totalReferences += stackPtr->distanceCounts[d];
+          }
+          totalReferences += stackPtr->deepReferences + stackPtr->coldReferences;
+          coldReferences += stackPtr->coldReferences;
+     }
+
+     printf("GLOBAL LRU MISS RATIO CURVE OVER %d WORKLOADS: %lld references, %lld cold misses\n",
+          runner->cfg->numberOfWorkloads, totalReferences, coldReferences);
+     printf("every process shares one LRU stack, compare with LRU under --global; the default local replacement\n"
+          "evicts only the faulting process' own pages and gives a different curve\n");
+     printf("frames       misses  miss ratio\n");
+     long long hits = 0;
+     int frames;
+     for (frames = 1; frames <= maxFrames; ++frames) {
+          hits += distanceCounts[frames];
+          printf("%6d %12lld    %f\n", frames, totalReferences - hits,
+               (double)(totalReferences - hits) / (double)totalReferences);
+     }
+
+     free(distanceCounts);
+}
+
+// prints the statistics of every trial and their average for each policy
+void printStatistics(config * cfg) {
      int polNum = 0;
-     int totalJobs = 0;
-     int totalHits = 0;
-     int totalMisses = 0;
-     for(polNum = 0; polNum < 5; ++polNum) {
+     int trialNum = 0;
+     long long totalJobs = 0;
+     long long totalHits = 0;
+     long long totalMisses = 0;
+     for(polNum = 0; polNum < NUM_POLICIES; ++polNum) {
           printf("\nSTATISTICS FOR POLICY %s\n", policyNames[polNum]);
           totalJobs = 0;
           totalHits = 0;
           totalMisses = 0;
-          for(trialNum = 0; trialNum < 5; ++trialNum) {
-               int i = trialNum * 5 + polNum;
-               printf("Trial %d statistics: number of jobs run = %3.2d, hit/miss ratio = %f \n", 
+          for(trialNum = 0; trialNum < cfg->numberOfWorkloads; ++trialNum) {
+               int i = trialNum * NUM_POLICIES + polNum;
+               printf("Trial %d statistics: number of jobs run = %3.2lld, hit/miss ratio = %f \n", 
                     trialNum, trial_statistics[i][0], 
                     (((float)trial_statistics[i][1])/((float)trial_statistics[i][2])));
                totalJobs += trial_statistics[i][0];
@@ -720,7 +5039,235 @@ int main() {
                totalMisses += trial_statistics[i][2];
           }
           printf("Average of all trials: number of jobs run = %3.2f, hit/miss ratio = %f \n",
-               ((float)totalJobs/5), (((float)totalHits) / ((float)totalMisses)));  
+               ((float)totalJobs/cfg->numberOfWorkloads), (((float)totalHits) / ((float)totalMisses)));  
+     }
+}
+
+// prints every trial's fault rate over the run in 10 second windows, a rate that climbs while
+// jobs are still being admitted is the signature of thrashing
+void printThrashingIndicators(config * cfg) {
+     double windowSeconds = (double)cfg->trialSeconds / THRASHING_WINDOWS;
+     int polNum;
+     for (polNum = 0; polNum < NUM_POLICIES; ++polNum) {
+          printf("\nTHRASHING INDICATORS FOR POLICY %s\n", policyNames[polNum]);
+          int workloadNum;
+          for (workloadNum = 0; workloadNum < cfg->numberOfWorkloads; ++workloadNum) {
+               thrashingStats * statsPtr = &trial_thrashing[workloadNum * NUM_POLICIES + polNum];
+               printf("Trial %d: suspensions = %d, ticks held back = %d, peak faults/s = %d, faults/s per %gs:",
+                    workloadNum, statsPtr->suspensions, statsPtr->heldBackTicks, statsPtr->peakFaultsPerSecond, windowSeconds);
+               int window;
+               for (window = 0; window < THRASHING_WINDOWS; ++window)
+                    printf(" %.1f", statsPtr->faultsPerWindow[window] / windowSeconds);
+               printf("\n");
+          }
+     }
+}
+
+// prints how many prefetched pages were used before being evicted and the faults they saved, plus the
+// ticks references spent waiting on the disk
+void printPrefetchStatistics(config * cfg) {
+     int polNum;
+     for (polNum = 0; polNum < NUM_POLICIES; ++polNum) {
+          printf("\nPREFETCH STATISTICS FOR POLICY %s\n", policyNames[polNum]);
+          prefetchStats total;
+          memset(&total, 0, sizeof(total));
+          int workloadNum;
+          for (workloadNum = 0; workloadNum < cfg->numberOfWorkloads; ++workloadNum) {
+               prefetchStats * statsPtr = &trial_prefetch[workloadNum * NUM_POLICIES + polNum];
+               printf("Trial %d: prefetched = %lld, used = %lld, unused = %lld, evicted unused = %lld, faults saved = %lld, "
+                    "late = %lld, disk stall ticks = %lld\n", workloadNum, statsPtr->issued, statsPtr->used,
+                    statsPtr->issued - statsPtr->used, statsPtr->wasted, statsPtr->savedFaults, statsPtr->lateHits,
+                    statsPtr->stallTicks);
+               total.issued += statsPtr->issued;
+               total.used += statsPtr->used;
+               total.savedFaults += statsPtr->savedFaults;
+               total.stallTicks += statsPtr->stallTicks;
+          }
+          printf("Average of all trials: prefetch accuracy = %f, faults saved = %3.2f, disk stall ticks = %3.2f\n",
+               total.issued ? (float)total.used / total.issued : 0.0f, (float)total.savedFaults / cfg->numberOfWorkloads,
+               (float)total.stallTicks / cfg->numberOfWorkloads);
+     }
+}
+
+// prints a binary event log in the simulator's text notification layout
+void formatEventLog(char * data, size_t length) {
+     size_t offset = 0;
+     while (offset + sizeof(logRecord) <= length) {
+          logRecord record;
+          memcpy(&record, data + offset, sizeof(logRecord));
+          int * payload = (int *)(data + offset + sizeof(logRecord));
+          offset += sizeof(logRecord) + sizeof(int) * record.payloadWords;
+          if (offset > length) {
+               printf("ERROR EVENT LOG IS TRUNCATED\n");
+               exit(1);
+          }
+          int seconds = (record.time*100)/1000;
+          int millis = (record.time*100)%1000;
+
+          switch (record.event) {
+               case LOG_TRIAL:
+                    printVisualDivider();
+                    printf("\nRUNNING POLICY: %s\n", policyNames[payload[0]]);
+                    break;
+               case LOG_ENTER:
+                    printf("\nSWAPPING time: %d.%03d, proc: %3d, Enter, size: %2d, service: %d seconds\n", 
+                         seconds, millis, record.pid, payload[0], payload[1]/10);
+                    break;
+               case LOG_EXIT:
+                    printf("\nSWAPPING time: %d.%03d, proc: %3d,  Exit, size: %2d, service: %d seconds\n", 
+                         seconds, millis, record.pid, payload[0], payload[1]/10);
+                    break;
+               case LOG_MAP: {
+                    printf("Memory map\n");
+                    int entriesPerLine = 20;
+                    int i;
+                    for (i = 0; i < record.payloadWords; ++i) {
+                         if (payload[i] >= 0)
+                              printf("%03d ", payload[i]);
+                         else
+                              printf("... ");
+                         if (i % entriesPerLine == entriesPerLine - 1)
+                              printf("\n");
+                    }
+                    printf("\n");
+                    break;
+               }
+               case LOG_HIT:
+                    printf("REF HIT  time: %d.%03d, proc: %3d, ref page: %2d, frame: %2d\n",
+                         seconds, millis, record.pid, payload[0], payload[1]);
+                    break;
+               case LOG_MISS:
+                    printf("REF MISS time: %d.%03d, proc: %3d, ref page: %2d, frame: %2d\n",
+                         seconds, millis, record.pid, payload[0], payload[1]);
+                    break;
+               case LOG_MISS_REPLACE:
+                    printf("REF MISS time: %d.%03d, proc: %3d, ref page: %2d, frame: %2d, page out: %2d\n",
+                         seconds, millis, record.pid, payload[0], payload[1], payload[2]);
+                    break;
+               default:
+                    printf("ERROR UNKNOWN EVENT LOG RECORD %d\n", record.event);
+                    exit(1);
+          }
+     }
+}
+
+// offline formatter: prints an event log file written with --log
+void formatEventLogFile(char * path) {
+     int fd = open(path, O_RDONLY);
+     struct stat st;
+     if (fd < 0 || fstat(fd, &st) != 0) {
+          printf("ERROR OPENING EVENT LOG %s\n", path);
+          exit(1);
+     }
+     if (st.st_size > 0) {
+          char * data = mmap(NULL, st.st_size, PROT_READ, MAP_PRIVATE, fd, 0);
+          if (data == MAP_FAILED) {
+               printf("ERROR MAPPING EVENT LOG %s\n", path);
+               exit(1);
+          }
+          formatEventLog(data, st.st_size);
+          munmap(data, st.st_size);
+     }
+     close(fd);
+}
+
+int main(int argc, char ** argv) {
+     config cfg;
+     parseArguments(argc, argv, &cfg);
+
+     if (cfg.formatLogPath) {
+          formatEventLogFile(cfg.formatLogPath);
+          return 0;
+     }
+     if (cfg.saveWorkloadsPath) {
+          saveWorkloads(&cfg);
+          return 0;
+     }
+     selectFrameScanKernel(cfg.scanKernel);
+     if (cfg.benchLayout) {
+          benchmarkFrameLayout(&cfg);
+          return 0;
+     }
+     if (cfg.benchSuite) {
+          benchmarkSuite(&cfg);
+          return 0;
+     }
+
+     trialRunner runner;
+     memset(&runner, 0, sizeof(runner));
+     runner.cfg = &cfg;
+
+     if (cfg.recordPath) {
+          recordWorkloads(&cfg);
+          return 0;
+     }
+
+     if (cfg.sweepPath) {
+          runSweep(&runner);
+          return 0;
+     }
+
+     if (cfg.replayPath) {
+          mapTrace(cfg.replayPath, &runner.trace);
+          cfg.numberOfWorkloads = runner.trace.header->numberOfSegments;
+     }
+     allocateTrialResults(&cfg);
+     if (cfg.metricsPath)
+          cfg.metricsSinkPtr = openMetricsSink(&cfg);
+
+     if (cfg.mrcFrames > 0) {
+          int workloadNum;
+          runner.stacks = malloc(cfg.numberOfWorkloads * sizeof(stackDistance *));
+          for (workloadNum = 0; workloadNum < cfg.numberOfWorkloads; ++workloadNum)
+               runner.stacks[workloadNum] = createStackDistance(cfg.mrcFrames);
+          runTrials(&runner);
+          printMissRatioCurve(&runner);
+          for (workloadNum = 0; workloadNum < cfg.numberOfWorkloads; ++workloadNum)
+               freeStackDistance(runner.stacks[workloadNum]);
+          free(runner.stacks);
+          return 0;
+     }
+
+     if (cfg.forkSeconds >= 0)
+          runForkedTrials(&cfg);
+     else
+          runTrials(&runner);
+     if (cfg.metricsSinkPtr)
+          closeMetricsSink(cfg.metricsSinkPtr, cfg.metricsPath);
+
+     int trialNum = 0;
+     if (cfg.replayPath) {
+          printf("\nREPLAYED %d WORKLOADS FROM %s\n", runner.trace.header->numberOfSegments, cfg.replayPath);
+          unmapTrace(&runner.trace);
+     }
+     FILE * logFile = NULL;
+     if (cfg.logPath && !(logFile = fopen(cfg.logPath, "wb"))) {
+          printf("ERROR OPENING EVENT LOG %s\n", cfg.logPath);
+          exit(1);
+     }
+     for (trialNum = 0; trialNum < NUM_POLICIES && runner.traces[trialNum]; ++trialNum) {
+          if (logFile)
+               fwrite(runner.traces[trialNum], 1, runner.traceLengths[trialNum], logFile);
+          else
+               formatEventLog(runner.traces[trialNum], runner.traceLengths[trialNum]);
+          free(runner.traces[trialNum]);
+     }
+     if (logFile)
+          fclose(logFile);
+
+     if (cfg.resultsFormat == RESULTS_TEXT) {
+          printVisualDivider();
+          printStatistics(&cfg);
+     }
+     else
+          writeResults(&cfg);
+     if (cfg.reportThrashing || cfg.globalScope || cfg.loadControl != LOAD_NONE) {
+          printVisualDivider();
+          printThrashingIndicators(&cfg);
+     }
+     if (cfg.prefetchDepth > 0 || cfg.diskLatency > 0) {
+          printVisualDivider();
+          printPrefetchStatistics(&cfg);
      }
 
      return 0;